@@ -0,0 +1,100 @@
+#!/usr/bin/python3
+
+## Runs the benchmarks of firmware/bench.c in mspdebug's simulator,
+## printing the exact cycle count of each and failing if any of them
+## exceeds its budget from firmware/benchbudgets.txt.
+
+## The simulator is instruction accurate for the original MSP430
+## core, so bench.elf is built with -mcpu=msp430.  Counts are then a
+## little pessimistic for the watch, whose CPUX saves registers with
+## PUSHM and POPM, but they are exact, repeatable and need no watch.
+
+## With --report, budgets are printed but never fail the run, which is
+## how CI runs it until the budgets have been set from measured counts.
+
+## Usage: bench.py [-b benchbudgets.txt] [--report] bench.elf
+
+import sys, re, argparse, subprocess;
+
+#Cycles in a quarter second frame at 32kHz.
+FRAME=8192;
+
+def readbudgets(filename):
+    """Returns a list of (name,cycles) in the order of bench.c."""
+    budgets=[];
+    for line in open(filename):
+        line=line.split("#")[0].split();
+        if len(line)==2:
+            budgets.append((line[0],int(line[1])));
+    return budgets;
+
+def simulate(elf, count, mspdebug="mspdebug", timeout=120):
+    """Runs count benchmarks, returning the MCLK count at each mark."""
+    cmds=["prog "+elf, "simio add tracer tr", "setbreak bench_mark"];
+    for i in range(2*count):
+        cmds+=["run", "simio info tr"];
+    try:
+        out=subprocess.run([mspdebug, "sim"]+cmds, timeout=timeout,
+                           stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                           universal_newlines=True).stdout;
+    except subprocess.TimeoutExpired:
+        print("mspdebug timed out.  Is bench.c in step with the budgets?");
+        sys.exit(1);
+
+    #Each stop dumps the registers, with the mark's index in R12,
+    #and then the tracer gives the total MCLK count.
+    marks=[];
+    index=None;
+    for line in out.splitlines():
+        m=re.search(r"R12:\s*([0-9a-fA-F]+)", line);
+        if m:
+            index=int(m.group(1),16);
+        m=re.match(r"\s*MCLK:\s*(\d+)", line);
+        if m and index is not None:
+            marks.append((index,int(m.group(1))));
+            index=None;
+    if len(marks)!=2*count:
+        print(out);
+        print("Expected %d marks from mspdebug, but got %d."
+              % (2*count,len(marks)));
+        sys.exit(1);
+    for i in range(2*count):
+        if marks[i][0]!=i:
+            print("Mark %d came from bench_mark(%d).  Is bench.c in step with the budgets?"
+                  % (i,marks[i][0]));
+            sys.exit(1);
+    return [m[1] for m in marks];
+
+def main():
+    parser=argparse.ArgumentParser(description="Cycle counts of bench.elf.");
+    parser.add_argument("-b","--budgets",default="benchbudgets.txt",
+                        help="Budgets, one 'name cycles' per line.");
+    parser.add_argument("--mspdebug",default="mspdebug",
+                        help="mspdebug executable.");
+    parser.add_argument("-r","--report",action="store_true",
+                        help="Print the counts without failing on budgets.");
+    parser.add_argument("elf",help="bench.elf from 'make bench'.");
+    args=parser.parse_args();
+
+    budgets=readbudgets(args.budgets);
+    clocks=simulate(args.elf, len(budgets), args.mspdebug);
+    cycles=[clocks[2*i+1]-clocks[2*i] for i in range(len(budgets))];
+
+    #The first benchmark is empty, measuring the marks themselves.
+    overhead=cycles[0];
+    failures=0;
+    print("%-24s %8s %8s %7s" % ("benchmark","cycles","budget","frame"));
+    for i in range(1,len(budgets)):
+        (name,budget)=budgets[i];
+        c=cycles[i]-overhead;
+        over=c>budget;
+        failures+=over;
+        print("%-24s %8d %8d %6.1f%% %s"
+              % (name,c,budget,c*100.0/FRAME,"OVER BUDGET" if over else ""));
+    if failures:
+        print("%d benchmarks exceeded their budgets." % failures);
+        if not args.report:
+            sys.exit(1);
+
+if __name__=="__main__":
+    main();
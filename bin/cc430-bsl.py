@@ -182,6 +182,18 @@ class BSL:
         resp=self.transact(b'\x12'+al+am+ah)
         return resp[1:]
     
+    def crccheck(self,adr,length):
+        """Returns the BSL's two-byte CRC of a range of memory, in the
+        same order as crc() so that the two can be compared."""
+        al=bytes({adr&0xFF})
+        am=bytes({(adr>>8)&0xFF})
+        ah=bytes({(adr>>16)&0xFF})
+        ll=bytes({length&0xFF})
+        lh=bytes({(length>>8)&0xFF})
+        resp=self.transact(b'\x16'+al+am+ah+ll+lh)
+        assert(resp[0]==0x3a);
+        return resp[1:3]
+
     def unlocklockinfo(self):
         """Unlocks or locks Info FLash."""
         resp=self.transact(b'\x13')
@@ -216,7 +228,7 @@ class BSL:
         #self.serial.setBaudrate(rate); #Old convention.
         self.serial.baudrate=rate;      #New convention.
     
-    MAXLEN=256; #Maximum bytes per read request.
+    MAXLEN=256; #Maximum bytes per read or write request.
     def readbulk(self,adr,length):
         """Reads a large volume from the target, in multiple transactions."""
         i=adr;
@@ -249,14 +261,107 @@ class BSL:
         if verb==0: #Data
             self.write(adr,data);
 
-    def writeihexfile(self,filename):
-        """Writes an Intel Hex file to the CC430."""
+    #Flash is erased in segments of these sizes.
+    MAINFLASH=0x8000; MAINSEGMENT=512;
+    INFOFLASH=0x1800; INFOSEGMENT=128;
+    def segmentof(self,adr):
+        """Returns the base and size of the Flash segment holding adr."""
+        if adr>=self.MAINFLASH and adr<=0xFFFF:
+            size=self.MAINSEGMENT;
+        elif adr>=self.INFOFLASH and adr<self.INFOFLASH+4*self.INFOSEGMENT:
+            size=self.INFOSEGMENT;
+        else:
+            print("Error: 0x%04x is not in Flash." % adr);
+            sys.exit(1);
+        return adr&~(size-1), size;
+
+    def readihexfile(self,filename):
+        """Returns a dictionary of bytes by address from an Intel Hex file."""
+        image={};
+        base=0;
+        for line in open(filename,'r'):
+            line=line.strip();
+            if not line:
+                continue;
+            assert(line[0]==':');
+            length=int(line[1:3],16);
+            adr=int(line[3:7],16);
+            verb=int(line[7:9],16);
+            data=bytes.fromhex(line[9:(9+length*2)])
+            if verb==0:   #Data
+                for i,d in enumerate(data):
+                    image[base+adr+i]=d;
+            elif verb==4: #Extended linear address
+                base=int.from_bytes(data,'big')<<16;
+        return image;
+
+    def blocksof(self,image):
+        """Merges an image from readihexfile() into a sorted list of
+        contiguous (address, bytes) blocks."""
+        blocks=[];
+        for adr in sorted(image):
+            if blocks and blocks[-1][0]+len(blocks[-1][1])==adr:
+                blocks[-1][1].append(image[adr]);
+            else:
+                blocks.append((adr,bytearray([image[adr]])));
+        return [(adr,bytes(data)) for adr,data in blocks];
+
+    def writeihexfile(self,filename,verify=True):
+        """Writes an Intel Hex file to the CC430.  Records are merged
+        into contiguous blocks, so that each write carries MAXLEN
+        bytes rather than one 16-byte line.  The blocks are read back
+        afterward, unless verify is False."""
+        blocks=self.blocksof(self.readihexfile(filename));
+        chunks=[(adr+i,data[i:i+self.MAXLEN])
+                for adr,data in blocks
+                for i in range(0,len(data),self.MAXLEN)];
         bar=progressbar.ProgressBar();
-        f=open(filename,'r');
-        lines=f.readlines();
-        for l in bar(lines):
-            self.writeihexline(l.strip());
-
+        for adr,data in bar(chunks):
+            self.write(adr,data);
+        if verify:
+            self.verifyblocks(blocks);
+
+    def verifyblocks(self,blocks):
+        """Reads back (address, bytes) blocks, exiting on a mismatch."""
+        for adr,data in blocks:
+            readback=self.readbulk(adr,len(data));
+            if readback!=data:
+                i=next(i for i in range(len(data)) if readback[i]!=data[i]);
+                print("Error: Verify failed at 0x%04x, 0x%02x should be 0x%02x."
+                      % (adr+i,readback[i],data[i]));
+                sys.exit(1);
+        print("Verified %d bytes in %d blocks." % (sum(len(d) for a,d in blocks),len(blocks)));
+
+    def writeihexdiff(self,filename):
+        """Writes an Intel Hex file to the CC430, erasing and writing
+        only those segments whose CRC differs from the image.  Main
+        Flash outside the image is erased if it isn't already blank,
+        but Info Flash outside the image (the codeplug) is left alone.
+        Returns the count of segments that were rewritten."""
+        image=self.readihexfile(filename);
+        segments=set(self.segmentof(adr) for adr in image);
+        segments.update((adr,self.MAINSEGMENT)
+                        for adr in range(self.MAINFLASH,0x10000,self.MAINSEGMENT));
+
+        #First we find the segments that differ, one CRC apiece.
+        changed=[];
+        for base,size in sorted(segments):
+            expected=bytes(image.get(adr,0xFF) for adr in range(base,base+size));
+            if self.crccheck(base,size)!=self.crc(expected):
+                changed.append((base,size,expected));
+        print("%d of %d segments have changed." % (len(changed),len(segments)));
+
+        #Then we rewrite them, skipping the blank tails.
+        bar=progressbar.ProgressBar();
+        for base,size,expected in bar(changed):
+            self.erasesegment(base);
+            data=expected.rstrip(b'\xff');
+            if data:
+                self.writebulk(base,data);
+            if self.crccheck(base,size)!=self.crc(expected):
+                print("Error: Segment at 0x%04x failed to verify." % base);
+                sys.exit(1);
+        return len(changed);
 
     def handlepasswordline(self, password, line):
         """Returns a password fragment from the line, if available."""
@@ -342,6 +447,8 @@ if __name__=='__main__':
     parser.add_argument('-p','--port',
                         help='Serial Port',default='/dev/ttyUSB0');
     parser.add_argument('-f','--file', help='Flash File');
+    parser.add_argument('-x','--diff',
+                        help='Flash only the segments that changed, by CRC.',action='count');
     parser.add_argument('-P','--password', help='Password File or Hex');
     parser.add_argument('-d','--dump',
                         help='Produce a core dump.',action='count');
@@ -350,7 +457,9 @@ if __name__=='__main__':
     parser.add_argument('-u','--unlock',
                         help='Unlock BSL.',action='count');
     parser.add_argument('-r','--rate',
-                        help='Baud Rate', default=9600);
+                        help='Baud Rate', default=115200);
+    parser.add_argument('-n','--noverify',
+                        help='Skip reading back a written file.',action='count');
     
     args = parser.parse_args()
 
@@ -379,9 +488,14 @@ if __name__=='__main__':
     if args.unlock!=None:
         #print "Unlocking."
         bsl.unlock(args.password);
-    if args.file!=None:
+    if args.file!=None and args.diff!=None:
+        #A wrong password mass erases, and then every segment differs.
+        bsl.unlock(args.password);
+        print(("Writing changes from %s as Intel hex." % args.file))
+        bsl.writeihexdiff(args.file);
+    elif args.file!=None:
         print(("Writing %s as Intel hex." % args.file))
-        bsl.writeihexfile(args.file);
+        bsl.writeihexfile(args.file,verify=args.noverify==None);
 
     ## Peviously, we manually wrote the time to 0xFF00.  This is now
     ## handled by buildtime.h, but I wouldn't object to writing the
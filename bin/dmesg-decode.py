@@ -0,0 +1,108 @@
+#!/usr/bin/python3
+
+## Renders a dmesg buffer from a DMESG_TOKENS build as text.  Plain
+## characters pass through unchanged, while each record of 0xFF, a
+## 16-bit token and raw arguments is formatted on the host with the
+## dictionary that dmesg-tokens.py made at build time.  The event
+## markers of a DMESG_MARKS build are skipped; energymarks.py reads
+## those.
+##
+## Usage: dmesg-decode.py dmesgfmt.json [dmesg.bin]
+
+from __future__ import print_function
+import sys, re, json, struct
+
+TOKENMARK=0xFF
+MARKBYTE=0xFE
+
+#Conversions that tinyprintf understands.
+conversion=re.compile(r'%([-0 ]?[0-9]*)(l?)([diuxXcs%])');
+
+
+class Decoder:
+    def __init__(self,dictionary):
+        self.dictionary={int(k,16):v for k,v in dictionary.items()};
+        self.pending=b'';
+
+    def record(self,data,i):
+        """Renders the record at data[i], returning the text and the
+        index after it, or None if the record is incomplete."""
+        if i+3>len(data):
+            return None;
+        token=data[i+1]|(data[i+2]<<8);
+        i+=3;
+        fmt=self.dictionary.get(token);
+        if fmt==None:
+            return ("<token 0x%04x>"%token, i);
+
+        out="";
+        last=0;
+        for m in conversion.finditer(fmt):
+            out+=fmt[last:m.start()];
+            last=m.end();
+            flags,size,kind=m.groups();
+            if kind=='%':
+                out+='%';
+                continue;
+            if kind=='s':
+                end=data.find(b'\0',i);
+                if end<0:
+                    return None;
+                out+=("%"+flags+"s") % data[i:end].decode('latin-1');
+                i=end+1;
+                continue;
+            n=4 if size else 2;
+            if i+n>len(data):
+                return None;
+            value=struct.unpack("<I" if n==4 else "<H", data[i:i+n])[0];
+            i+=n;
+            if kind in 'di' and value>=1<<(8*n-1):
+                value-=1<<(8*n);
+            if kind=='c':
+                out+=chr(value&0xFF);
+            else:
+                out+=("%"+flags+kind.replace('u','d').replace('i','d')) % value;
+        out+=fmt[last:];
+        return (out,i);
+
+    def decode(self,data):
+        """Decodes more of the buffer, holding back a partial record
+        until the rest arrives."""
+        data=self.pending+data;
+        self.pending=b'';
+        out="";
+        i=0;
+        while i<len(data):
+            if data[i]==MARKBYTE:
+                #Six bytes, then a label ending in zero.
+                end=data.find(b'\0',i+6);
+                if end<0:
+                    self.pending=data[i:];
+                    break;
+                i=end+1;
+            elif data[i]==TOKENMARK:
+                r=self.record(data,i);
+                if r==None:
+                    self.pending=data[i:];
+                    break;
+                text,i=r;
+                out+=text;
+            else:
+                if data[i]!=0:
+                    out+=chr(data[i]);
+                i+=1;
+        return out;
+
+
+if __name__ == '__main__':
+    if len(sys.argv)<2:
+        print("Usage: %s dmesgfmt.json [dmesg.bin]" % sys.argv[0]);
+        sys.exit(1);
+    with open(sys.argv[1]) as f:
+        decoder=Decoder(json.load(f));
+    if len(sys.argv)>2:
+        with open(sys.argv[2],'rb') as f:
+            data=f.read();
+    else:
+        data=sys.stdin.buffer.read();
+    sys.stdout.write(decoder.decode(data));
@@ -0,0 +1,42 @@
+#!/usr/bin/python3
+
+## Collects the printf() format strings of a DMESG_TOKENS build into
+## a dictionary, so that dmesg-decode.py can render the tokens that
+## the watch logs.  Each token is the offset of its format string in
+## the .dmesgfmt section of goodwatch.elf.
+
+from __future__ import print_function
+import sys, json
+
+from elftools.elf.elffile import ELFFile
+
+
+def tokens(stream):
+    """Returns a dictionary of tokens to format strings."""
+    elffile=ELFFile(stream);
+    section=elffile.get_section_by_name('.dmesgfmt');
+    if section==None:
+        print("No .dmesgfmt section.  Was this built with DMESG_TOKENS=1?");
+        sys.exit(1);
+    data=section.data();
+
+    #Strings are null terminated, perhaps with padding between them.
+    toret={};
+    i=0;
+    while i<len(data):
+        end=data.index(b'\0',i);
+        if end>i:
+            toret["0x%04x"%i]=data[i:end].decode('latin-1');
+        i=end+1;
+    return toret;
+
+
+if __name__ == '__main__':
+    if len(sys.argv)!=3:
+        print("Usage: %s goodwatch.elf dmesgfmt.json" % sys.argv[0]);
+        sys.exit(1);
+    with open(sys.argv[1],'rb') as f:
+        dictionary=tokens(f);
+    with open(sys.argv[2],'w') as f:
+        json.dump(dictionary,f,indent=1,sort_keys=True);
+    print("%d dmesg tokens in %s." % (len(dictionary),sys.argv[2]));
@@ -0,0 +1,213 @@
+#!/usr/bin/python3
+
+## Charges an EnergyTrace capture to the event markers that a
+## DMESG_MARKS build writes into its dmesg buffer.  Where
+## batterylife.py averages the whole capture, this reports the charge
+## of each applet, of each kind of span (draws, radio on-time and
+## receive windows) and, with -v, of every segment between markers.
+
+## The markers carry the RTC's minute, second and 32kHz prescaler, but
+## the capture counts from its own start, so the two are lined up by
+## sliding the markers along the capture until the draws and other
+## spans hold the most charge.  That works because those spans are
+## when the CPU or radio is awake.  Give --offset to skip the search.
+
+## Both inputs are saved files, so nothing here needs a watch:
+## energytrace.txt from energytrace-util and the raw 2kB dmesg.bin
+## from 'make sbwdmesg', taken right after the capture.
+
+## Usage: energymarks.py [-v] [--offset s] energytrace.txt dmesg.bin
+
+import sys, bisect, argparse;
+
+MARKBYTE=0xFE;
+#Uppercase begins a span, lowercase ends it.  See dmesg.h.
+SPANS={'D':"draw", 'R':"radio", 'X':"rx window"};
+EVENTS="A"+"".join(SPANS)+"".join(SPANS).lower();
+#Longest label, which is an applet name.
+MAXLABEL=16;
+
+def readtrace(filename):
+    """Returns the times and currents of an energytrace-util dump."""
+    times=[];
+    amps=[];
+    for line in open(filename):
+        words=line.split();
+        if not words or line[0]=='#':
+            continue;
+        times.append(float(words[0]));
+        amps.append(float(words[1]));
+    if len(times)<2:
+        print("%s holds no samples." % filename);
+        sys.exit(1);
+    return (times,amps);
+
+class Charge:
+    """Charge of a capture between any two times, in microcoulombs."""
+    def __init__(self,times,amps):
+        self.times=times;
+        self.total=[0.0];
+        for i in range(1,len(times)):
+            self.total.append(self.total[-1]
+                              +amps[i-1]*(times[i]-times[i-1])*1e6);
+    def at(self,t):
+        """Charge from the start of the capture to t."""
+        i=bisect.bisect_right(self.times,t)-1;
+        if i<0:
+            return 0.0;
+        if i>=len(self.times)-1:
+            return self.total[-1];
+        frac=(t-self.times[i])/(self.times[i+1]-self.times[i]);
+        return self.total[i]+frac*(self.total[i+1]-self.total[i]);
+    def between(self,a,b):
+        return self.at(b)-self.at(a);
+
+def readmarks(data):
+    """Returns (seconds, event, label) of every marker in a dmesg ring,
+    oldest first, with seconds counted from the oldest."""
+    ring=data+data[:6+MAXLABEL];
+    found=[];
+    for i in range(len(data)):
+        if ring[i]!=MARKBYTE or chr(ring[i+1]) not in EVENTS:
+            continue;
+        (event,minute,sec,ps0,ps1)=(chr(ring[i+1]),ring[i+2],ring[i+3],
+                                    ring[i+4],ring[i+5]);
+        end=ring.find(b'\0',i+6,i+6+MAXLABEL+1);
+        if minute>59 or sec>59 or end<0:
+            continue;
+        label=ring[i+6:end].decode('latin-1');
+        if (event=='A')!=(len(label)>0) or not label.isprintable():
+            continue;
+        t=minute*60+sec+((ps1&0x7F)*256+ps0)/32768.0;
+        found.append((t,event,label));
+    if not found:
+        return [];
+
+    #The ring wraps where time jumps furthest, counting mod an hour.
+    n=len(found);
+    gaps=[(found[(i+1)%n][0]-found[i][0])%3600 for i in range(n)];
+    first=(gaps.index(max(gaps))+1)%n;
+    found=found[first:]+found[:first];
+    marks=[];
+    t=0.0;
+    for i in range(n):
+        if i:
+            t+=(found[i][0]-found[i-1][0])%3600;
+        marks.append((t,found[i][1],found[i][2]));
+    return marks;
+
+def spans(marks):
+    """Returns (kind, start, end) of every closed span."""
+    result=[];
+    opened={};
+    for (t,event,label) in marks:
+        if event in SPANS:
+            opened[event]=t;
+        elif event.upper() in opened:
+            result.append((SPANS[event.upper()],opened.pop(event.upper()),t));
+    return result;
+
+def align(charge, marks, closed):
+    """Returns the offset of the markers into the capture that puts
+    the most charge inside the spans."""
+    start=charge.times[0];
+    end=charge.times[-1];
+    length=marks[-1][0];
+    period=(end-start)/(len(charge.times)-1);
+
+    def score(offset):
+        return sum(charge.between(a+offset,b+offset) for (k,a,b) in closed);
+
+    #A coarse search, then a fine one around the best.
+    step=period*10;
+    offsets=[start-length+i*step for i in range(int((end-start+length)/step)+1)];
+    best=max(offsets,key=score);
+    offsets=[best+i*period for i in range(-10,11)];
+    return max(offsets,key=score);
+
+def main():
+    parser=argparse.ArgumentParser(description="Charge of each marked event in an EnergyTrace capture.");
+    parser.add_argument('-v','--verbose',action='store_true',
+                        help='Print the charge of every segment.');
+    parser.add_argument('--offset',type=float,
+                        help='Seconds into the capture of the oldest marker.');
+    parser.add_argument('trace',help='Text dump from energytrace-util.');
+    parser.add_argument('dmesg',help='Raw dmesg buffer of a DMESG_MARKS build.');
+    args=parser.parse_args();
+
+    (times,amps)=readtrace(args.trace);
+    charge=Charge(times,amps);
+    with open(args.dmesg,'rb') as f:
+        marks=readmarks(f.read());
+    if len(marks)<2:
+        print("Found %d markers.  Was the firmware built with DMESG_MARKS=1?" % len(marks));
+        sys.exit(1);
+    closed=spans(marks);
+
+    if args.offset is not None:
+        offset=args.offset;
+    elif closed:
+        offset=align(charge,marks,closed);
+    else:
+        print("No spans to line up with the capture, so please give --offset.");
+        sys.exit(1);
+    start=max(times[0],offset);
+    end=min(times[-1],offset+marks[-1][0]);
+    print("%d markers over %.1fs, the oldest at %.3fs into the capture."
+          % (len(marks),marks[-1][0],offset));
+    if end<=start:
+        print("The markers don't overlap the capture.");
+        sys.exit(1);
+    print("They cover %.1fs of the %.1fs capture, drawing %.1fuC.\n"
+          % (end-start,times[-1]-times[0],charge.between(start,end)));
+
+    #Each kind of span, counting only those inside the capture.
+    print("%-12s %6s %10s %12s %10s %10s"
+          % ("span","count","seconds","charge(uC)","avg(uA)","uC each"));
+    for kind in SPANS.values():
+        inside=[(a+offset,b+offset) for (k,a,b) in closed
+                if k==kind and a+offset>=start and b+offset<=end];
+        if not inside:
+            continue;
+        seconds=sum(b-a for (a,b) in inside);
+        uc=sum(charge.between(a,b) for (a,b) in inside);
+        print("%-12s %6d %10.3f %12.2f %10.1f %10.3f"
+              % (kind,len(inside),seconds,uc,
+                 uc/seconds if seconds else 0,uc/len(inside)));
+
+    #Each applet, from its switch marker to the next.
+    applets={};
+    current=None;
+    for i in range(len(marks)):
+        (t,event,label)=marks[i];
+        if event=='A':
+            current=label;
+        if current is None or i+1==len(marks):
+            continue;
+        a=max(start,t+offset);
+        b=min(end,marks[i+1][0]+offset);
+        if b>a:
+            s=applets.setdefault(current,[0.0,0.0]);
+            s[0]+=b-a;
+            s[1]+=charge.between(a,b);
+    if applets:
+        print("\n%-16s %10s %12s %10s" % ("applet","seconds","charge(uC)","avg(uA)"));
+        for name in sorted(applets):
+            (seconds,uc)=applets[name];
+            print("%-16s %10.3f %12.2f %10.1f" % (name,seconds,uc,uc/seconds));
+
+    #Every segment between two markers, labeled by its first.
+    if args.verbose:
+        print("\n%10s %10s %-4s %-16s %12s %10s"
+              % ("start","seconds","mark","label","charge(uC)","avg(uA)"));
+        for i in range(len(marks)-1):
+            a=marks[i][0]+offset;
+            b=marks[i+1][0]+offset;
+            if a<start or b>end or b<=a:
+                continue;
+            uc=charge.between(a,b);
+            print("%10.4f %10.4f %-4s %-16s %12.3f %10.1f"
+                  % (a,b-a,marks[i][1],marks[i][2],uc,uc/(b-a)));
+
+if __name__=="__main__":
+    main();
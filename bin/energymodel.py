@@ -0,0 +1,159 @@
+#!/usr/bin/python3
+
+## Estimates the battery life of the watch from activity traces, such
+## as those written by 'appsim -t' in firmware/host.  Where
+## batterylife.py needs a watch on an EnergyTrace probe, this needs
+## nothing but the trace, so it can run in CI and catch power
+## regressions before they reach a wrist.
+
+## Each trace is one usage scenario.  Every frame of the trace is
+## charged to its applet by the figures of CURRENTS, so the report
+## gives the average current and projected CR2016 life of each
+## scenario, and of each applet as if the watch were left in it.
+
+## These are typical figures at 3V and 25C from the CC430F613x
+## datasheet, and the traces count cycles only roughly, so take the
+## projections as relative rather than absolute.  A --baseline report
+## from an earlier run makes it fail when any scenario's projected
+## life falls by more than --threshold percent.
+
+## Usage: energymodel.py [--json report.json] [--baseline old.json] trace...
+
+import sys, os, json, argparse;
+
+#Microamps drawn in each state, from the CC430F613x datasheet.
+CURRENTS={
+    "lpm3":     2.0,     #LPM3 with XT1 and the RTC running.
+    "lcd":      1.0,     #LCD_B driving 4-mux segments, static.
+    "lcdcp":    3.0,     #Extra for the LCD's charge pump.
+    "activemhz":230.0,   #Active mode from Flash, per MHz of MCLK.
+    "radioidle":1700.0,  #Radio core in IDLE, crystal running.
+    "radiorx":  16000.0, #RX at 433MHz and low data rates.
+    "radiotx":  17000.0, #TX at 433MHz and about 0dBm.
+    "ref":      100.0,   #REF module on.
+    "adc":      150.0,   #ADC12 converting.
+    "buzzer":   500.0,   #Timer_A1 toggling the piezo.
+};
+#CPU cycles of a function call and return that the trace doesn't see.
+CALLCYCLES=40;
+#Seconds at active current for each wakeup from LPM3.
+WAKEUPTIME=10e-6;
+
+#Nominal capacity of a CR2016, in mAh.
+CAPACITY=90.0;
+#Average days in a month.
+MONTHDAYS=365.25/12;
+
+COLUMNS=["frame","applet","cycles","active","calls","wakeups","mclk",
+         "radioidle","radiorx","radiotx","ref","adc","buzzer","lcdcp"];
+
+def readtrace(filename):
+    """Yields each frame of a trace as a dictionary."""
+    for line in open(filename):
+        if line[0]=='#':
+            continue;
+        words=line.split();
+        if len(words)!=len(COLUMNS):
+            print("%s: expected %d columns, but got %d."
+                  % (filename,len(COLUMNS),len(words)));
+            sys.exit(1);
+        frame=dict(zip(COLUMNS,words));
+        for k in COLUMNS[2:]:
+            frame[k]=int(frame[k]);
+        frame["applet"]=frame["applet"].replace("_"," ");
+        yield frame;
+
+def charge(frame):
+    """Returns the seconds and microcoulombs of a frame."""
+    mclk=float(frame["mclk"]);
+    seconds=frame["cycles"]/mclk;
+    active=(frame["active"]+frame["calls"]*CALLCYCLES)/mclk;
+    active+=frame["wakeups"]*WAKEUPTIME;
+    active=min(active,seconds);
+    uc=active*CURRENTS["activemhz"]*mclk/1e6;
+    uc+=(seconds-active)*CURRENTS["lpm3"];
+    uc+=seconds*CURRENTS["lcd"];
+    for k in ("radioidle","radiorx","radiotx","ref","adc","buzzer","lcdcp"):
+        uc+=frame[k]/mclk*CURRENTS[k];
+    return (seconds,uc);
+
+def months(microamps, capacity):
+    """Projected battery life in months at an average current."""
+    return capacity*1000.0/microamps/24.0/MONTHDAYS;
+
+def scenario(filename, capacity):
+    """Returns the report of one trace."""
+    total=[0.0,0.0];
+    applets={};
+    for frame in readtrace(filename):
+        (seconds,uc)=charge(frame);
+        a=applets.setdefault(frame["applet"],[0.0,0.0]);
+        for t in (a,total):
+            t[0]+=seconds;
+            t[1]+=uc;
+    if total[0]==0:
+        print("%s: no frames." % filename);
+        sys.exit(1);
+    report={"seconds":total[0], "microamps":total[1]/total[0],
+            "months":months(total[1]/total[0],capacity), "applets":{}};
+    for name in applets:
+        (seconds,uc)=applets[name];
+        report["applets"][name]={"seconds":seconds, "microamps":uc/seconds,
+                                 "months":months(uc/seconds,capacity)};
+    return report;
+
+def printreport(report):
+    """Prints each scenario, then its applets."""
+    for name in sorted(report["scenarios"]):
+        s=report["scenarios"][name];
+        print("%-20s %8.1fs %8.2fuA %6.1f months"
+              % (name,s["seconds"],s["microamps"],s["months"]));
+        for applet in sorted(s["applets"]):
+            a=s["applets"][applet];
+            print("    %-16s %8.1fs %8.2fuA %6.1f months"
+                  % (applet,a["seconds"],a["microamps"],a["months"]));
+
+def compare(report, baseline, threshold):
+    """Prints what changed since the baseline.  Returns False if any
+    scenario's life fell by more than threshold percent."""
+    ok=True;
+    for name in sorted(report["scenarios"]):
+        if name not in baseline["scenarios"]:
+            continue;
+        new=report["scenarios"][name]["months"];
+        old=baseline["scenarios"][name]["months"];
+        change=(new-old)*100.0/old;
+        print("\t%s: %.1f months, %+.1f%% since the baseline" % (name,new,change));
+        if change< -threshold:
+            print("ERROR: %s lost more than %.1f%% of its battery life." % (name,threshold));
+            ok=False;
+    return ok;
+
+def main():
+    parser=argparse.ArgumentParser(description="Battery life from activity traces.");
+    parser.add_argument('--capacity',type=float,default=CAPACITY,
+                        help='Battery capacity in mAh.');
+    parser.add_argument('--json',help='Write the report here.');
+    parser.add_argument('--baseline',help='Compare to this earlier report.');
+    parser.add_argument('--threshold',type=float,default=2.0,
+                        help='Percent of battery life that may be lost.');
+    parser.add_argument('traces',nargs='+',help='Traces from appsim -t.');
+    args=parser.parse_args();
+
+    report={"capacity":args.capacity, "scenarios":{}};
+    for filename in args.traces:
+        name=os.path.splitext(os.path.basename(filename))[0];
+        report["scenarios"][name]=scenario(filename,args.capacity);
+    printreport(report);
+
+    if args.json:
+        with open(args.json,'w') as f:
+            json.dump(report,f,indent=1,sort_keys=True);
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline=json.load(f);
+        if not compare(report,baseline,args.threshold):
+            sys.exit(1);
+
+if __name__=="__main__":
+    main();
@@ -0,0 +1,698 @@
+#!/usr/bin/python3
+
+## This is a client library for the GoodWatch's UART monitor.  It
+## speaks the framed protocol of firmware/uart.c and monitor.c over a
+## serial port, a pseudo-terminal or a TCP socket, and it keeps two
+## commands in flight so that batches don't pay a full round trip per
+## command.  bin/goodwatch.py is the command line tool on top of it.
+##
+## Commands go to the watch as "\x80"+ll+lh+msg+crc, and replies come
+## back as "\x00\x80"+ll+lh+msg+crc, where the CRC is the CCITT
+## checksum of the BSL over msg alone.  The watch answers a command
+## that it couldn't take with a single NAK byte instead of a frame.
+
+import time, struct, socket, os, collections;
+
+
+def ord16(word):
+    """Convert a 16-bit word from bytes."""
+    return word[0] | (word[1]<<8);
+def chr16(word):
+    """Convert a 16-bit word to bytes."""
+    return bytes([word&0xFF, (word>>8)&0xFF]);
+
+def crc16(msg):
+    """Returns the CCITT checksum of a message, as the BSL computes it."""
+    crc=0xFFFF;
+    for byte in msg:
+        x=((crc>>8)^byte)&0xFF;
+        x^=x>>4;
+        crc=((crc<<8)^(x<<12)^(x<<5)^x)&0xFFFF;
+    return crc;
+
+
+# Monitor verbs, from monitor.c.
+SETTURBOMODE = 0x00
+PEEK         = 0x01
+POKE         = 0x02
+LCDSTRING    = 0x03
+DMESG        = 0x04
+RANDINT      = 0x05
+SETBAUD      = 0x06
+READ         = 0x07
+WRITE        = 0x08
+RADIOONOFF   = 0x10
+RADIOCONFIG  = 0x11
+RADIORX      = 0x12
+RADIOTX      = 0x13
+RADIOSNIFF   = 0x14
+
+# Error replies, from uart.h.
+NAKS={
+    0x52: "bad CRC",
+    0x54: "bad length",
+    0x55: "watch busy",
+};
+
+# Sizes from the firmware.
+UARTBUFLEN   = 128    # Longest command or reply from the watch's buffers.
+READMAX      = 256    # Longest READ reply, streamed from memory.
+SNIFFHEADER  = 10     # Bytes of a sniffer record before the packet.
+
+# Commands in flight.  The watch has two receive buffers, so a third
+# command would be refused while the first reply is still going out.
+WINDOW       = 2
+
+
+# Radio Core Registers
+IOCFG2              =0x00    #IOCFG2   - GDO2 output pin configuration
+IOCFG1              =0x01    #IOCFG1   - GDO1 output pin configuration
+IOCFG0              =0x02    #IOCFG0   - GDO0 output pin configuration
+FIFOTHR             =0x03    #FIFOTHR  - RX FIFO and TX FIFO thresholds
+SYNC1               =0x04    #SYNC1    - Sync word, high byte
+SYNC0               =0x05    #SYNC0    - Sync word, low byte
+PKTLEN              =0x06    #PKTLEN   - Packet length
+PKTCTRL1            =0x07    #PKTCTRL1 - Packet automation control
+PKTCTRL0            =0x08    #PKTCTRL0 - Packet automation control
+ADDR                =0x09    #ADDR     - Device address
+CHANNR              =0x0A    #CHANNR   - Channel number
+FSCTRL1             =0x0B    #FSCTRL1  - Frequency synthesizer control
+FSCTRL0             =0x0C    #FSCTRL0  - Frequency synthesizer control
+FREQ2               =0x0D    #FREQ2    - Frequency control word, high byte
+FREQ1               =0x0E    #FREQ1    - Frequency control word, middle byte
+FREQ0               =0x0F    #FREQ0    - Frequency control word, low byte
+MDMCFG4             =0x10    #MDMCFG4  - Modem configuration
+MDMCFG3             =0x11    #MDMCFG3  - Modem configuration
+MDMCFG2             =0x12    #MDMCFG2  - Modem configuration
+MDMCFG1             =0x13    #MDMCFG1  - Modem configuration
+MDMCFG0             =0x14    #MDMCFG0  - Modem configuration
+DEVIATN             =0x15    #DEVIATN  - Modem deviation setting
+MCSM2               =0x16    #MCSM2    - Main Radio Control State Machine configuration
+MCSM1               =0x17    #MCSM1    - Main Radio Control State Machine configuration
+MCSM0               =0x18    #MCSM0    - Main Radio Control State Machine configuration
+FOCCFG              =0x19    #FOCCFG   - Frequency Offset Compensation configuration
+BSCFG               =0x1A    #BSCFG    - Bit Synchronization configuration
+AGCCTRL2            =0x1B    #AGCCTRL2 - AGC control
+AGCCTRL1            =0x1C    #AGCCTRL1 - AGC control
+AGCCTRL0            =0x1D    #AGCCTRL0 - AGC control
+WOREVT1             =0x1E    #WOREVT1  - High byte Event0 timeout
+WOREVT0             =0x1F    #WOREVT0  - Low byte Event0 timeout
+WORCTRL             =0x20    #WORCTRL  - Wake On Radio control
+FREND1              =0x21    #FREND1   - Front end RX configuration
+FREND0              =0x22    #FREDN0   - Front end TX configuration
+FSCAL3              =0x23    #FSCAL3   - Frequency synthesizer calibration
+FSCAL2              =0x24    #FSCAL2   - Frequency synthesizer calibration
+FSCAL1              =0x25    #FSCAL1   - Frequency synthesizer calibration
+FSCAL0              =0x26    #FSCAL0   - Frequency synthesizer calibration
+#RCCTRL1             =0x27    #RCCTRL1  - RC oscillator configuration
+#RCCTRL0             =0x28    #RCCTRL0  - RC oscillator configuration
+FSTEST              =0x29    #FSTEST   - Frequency synthesizer calibration control
+PTEST               =0x2A    #PTEST    - Production test
+AGCTEST             =0x2B    #AGCTEST  - AGC test
+TEST2               =0x2C    #TEST2    - Various test settings
+TEST1               =0x2D    #TEST1    - Various test settings
+TEST0               =0x2E    #TEST0    - Various test settings
+
+# status registers
+PARTNUM             =0x30    #PARTNUM    - Chip ID
+VERSION             =0x31    #VERSION    - Chip ID
+FREQEST             =0x32    #FREQEST     Frequency Offset Estimate from demodulator
+LQI                 =0x33    #LQI         Demodulator estimate for Link Quality
+RSSI                =0x34    #RSSI        Received signal strength indication
+MARCSTATE           =0x35    #MARCSTATE   Main Radio Control State Machine state
+WORTIME1            =0x36    #WORTIME1    High byte of WOR time
+WORTIME0            =0x37    #WORTIME0    Low byte of WOR time
+PKTSTATUS           =0x38    #PKTSTATUS   Current GDOx status and packet status
+VCO_VC_DAC          =0x39    #VCO_VC_DAC  Current setting from PLL calibration module
+TXBYTES             =0x3A    #TXBYTES     Underflow and number of bytes
+RXBYTES             =0x3B    #RXBYTES     Overflow and number of bytes
+
+# burst write registers
+PATABLE             =0x3E    #PATABLE - PA control settings table
+TXFIFO              =0x3F    #TXFIFO  - Transmit FIFO
+RXFIFO              =0x3F    #RXFIFO  - Receive FIFO
+
+
+# Radio Core Instructions
+# command strobes
+RF_SRES             =0x30    #SRES    - Reset chip.
+RF_SFSTXON          =0x31    #SFSTXON - Enable and calibrate frequency synthesizer.
+RF_SXOFF            =0x32    #SXOFF   - Turn off crystal oscillator.
+RF_SCAL             =0x33    #SCAL    - Calibrate frequency synthesizer and turn it off.
+RF_SRX              =0x34    #SRX     - Enable RX. Perform calibration if enabled.
+RF_STX              =0x35    #STX     - Enable TX. If in RX state, only enable TX if CCA passes.
+RF_SIDLE            =0x36    #SIDLE   - Exit RX / TX, turn off frequency synthesizer.
+#RF_SRSVD            =0x37    #SRVSD   - Reserved.  Do not use.
+RF_SWOR             =0x38    #SWOR    - Start automatic RX polling sequence (Wake-on-Radio)
+RF_SPWD             =0x39    #SPWD    - Enter power down mode when CSn goes high.
+RF_SFRX             =0x3A    #SFRX    - Flush the RX FIFO buffer.
+RF_SFTX             =0x3B    #SFTX    - Flush the TX FIFO buffer.
+RF_SWORRST          =0x3C    #SWORRST - Reset real time clock.
+RF_SNOP             =0x3D    #SNOP    - No operation. Returns status byte.
+
+# Standard mode for GoodWatch packets.  Needs to be better defined.
+beaconconfig=[
+  IOCFG0,0x06,   #GDO0 Output Configuration
+  FIFOTHR,0x47,  #RX FIFO and TX FIFO Thresholds
+  PKTCTRL1, 0x04, #No address check.
+  #PKTCTRL0, 0x05,#Packet Automation Control, variable length.
+  PKTCTRL0, 0x04, #Packet automation control, fixed length with CRC.
+  FSCTRL1,0x06,  #Frequency Synthesizer Control
+  #FREQ2,0x21,    #Frequency Control Word, High Byte
+  #FREQ1,0x62,    #Frequency Control Word, Middle Byte
+  #FREQ0,0x76,    #Frequency Control Word, Low Byte
+  MDMCFG4,0xF5,  #Modem Configuration
+  MDMCFG3,0x83,  #Modem Configuration
+  MDMCFG2,0x13,  #Modem Configuration
+  DEVIATN,0x15,  #Modem Deviation Setting
+#  MCSM0,0x10,    #Main Radio Control State Machine Configuration
+  FOCCFG,0x16,   #Frequency Offset Compensation Configuration
+  WORCTRL,0xFB,  #Wake On Radio Control
+  FREND0 , 0x11,      #  Front End TX Configuration
+  FSCAL3,0xE9,   #Frequency Synthesizer Calibration
+  FSCAL2,0x2A,   #Frequency Synthesizer Calibration
+  FSCAL1,0x00,   #Frequency Synthesizer Calibration
+  FSCAL0,0x1F,   #Frequency Synthesizer Calibration
+  TEST2,0x81,    #Various Test Settings
+  TEST1,0x35,    #Various Test Settings
+  TEST0,0x09,    #Various Test Settings
+  ADDR,  0x00,   # ADDR      Device address.
+  MCSM1, 0x30,   #MCSM1, return to IDLE after packet.  Or with 2 for TX carrier test.
+  MCSM0,  0x18,  # MCSM0     Main Radio Control State Machine configuration.
+  IOCFG2,  0x29, # IOCFG2    GDO2 output pin configuration.
+  IOCFG0,  0x06, # IOCFG0    GDO0 output pin configuration.
+  PKTLEN,  32,   # PKTLEN    Packet length.
+  0,0  #Null terminator.
+];
+
+
+# Example configuration from a cheap 4-button keychain remote.
+ookconfig=[
+    MDMCFG4, 0x86,      #  Modem Configuration
+    MDMCFG3, 0xD9,      #  Modem Configuration
+    MDMCFG2, 0x30,      #  Modem Configuration, no sync
+    FREND0 , 0x11,      #  Front End TX Configuration
+    FSCAL3 , 0xE9,      #  Frequency Synthesizer Calibration
+    FSCAL2 , 0x2A,      #  Frequency Synthesizer Calibration
+    FSCAL1 , 0x00,      #  Frequency Synthesizer Calibration
+    FSCAL0 , 0x1F,      #  Frequency Synthesizer Calibration
+    PKTCTRL1, 0x00,     #Packet automation control, fixed length without CRC.
+    PKTCTRL0, 0x00,     #Packet automation control, fixed length without CRC.
+    PKTLEN,  32,   # PKTLEN    Packet length.
+    0, 0
+];
+# Might be unique to Travis's set.
+ookpackets=[
+    "0000e8e8ee88e88ee888eee8888e8000", #A
+    "0000e8e8ee88e88ee888eee888e88000", #B
+    "0000e8e8ee88e88ee888eee88e888000", #C
+    "0000e8e8ee88e88ee888eee8e8888000"  #D
+];
+
+# 1200 Baud POCSAG for DAPNET
+pocsagconfig=[
+    MDMCFG4, 0xF5,      #  Modem Configuration, wide BW
+    #MDMCFG4, 0xC5,      #  Modem Configuration, narrow BW
+    MDMCFG3, 0x83,      #  Modem Configuration
+    MDMCFG2, 0x82,      #  2-FSK, current optimized, 16/16 sync
+    MDMCFG1, 0x72,      #  Long preamble.
+    # FREND0 , 0x11,      #  Front End TX Configuration
+
+    # #DEVIATN, 0x24,      # 9.5 kHz
+    DEVIATN, 0x31,      # 15 kHz
+
+    FSCAL3 , 0xE9,      #  Frequency Synthesizer Calibration
+    FSCAL2 , 0x2A,      #  Frequency Synthesizer Calibration
+    FSCAL1 , 0x00,      #  Frequency Synthesizer Calibration
+    FSCAL0 , 0x1F,      #  Frequency Synthesizer Calibration
+
+    PKTCTRL0, 0x00,     #  Packet automation control, fixed length without CRC.
+    PKTLEN,  60,        #  PKTLEN    Packet length.
+
+
+    #Matches on the packet, after the pramble.
+    SYNC1,   0x83,  # 832d first
+    SYNC0,   0x2d,
+    ADDR,    0xea,  # ea27 next, but we can only match one piece of it.
+
+    #This would match on the preamble, while the packet is still in flight.
+    #Handy for manually seeing the SYNC pattern, and the technique that firmware
+    #will use to wake up.
+    #SYNC1, 0xAA,
+    #SYNC0, 0xAA,
+    #ADDR, 0xAA,
+
+
+    TEST2,   0x81, #Who knows?
+    TEST1,   0x35,
+    TEST0,   0x09,
+
+    MCSM1,   0x30,   # MCSM1, return to IDLE after packet.  Or with 2 for TX carrier tes.
+    MCSM0,   0x10,   # MCSM0     Main Radio Control State Machine configuration.
+    IOCFG2,  0x29,   # IOCFG2    GDO2 output pin configuration.
+    IOCFG0,  0x06,   # IOCFG0    GDO0 output pin configuration.
+
+    FIFOTHR,  0x47,  # RX FIFO and TX FIFO Thresholds
+    #PKTCTRL1, 0x00,  # No address check, no status.
+    PKTCTRL1, 0x01,  # Exact address check, no status.
+
+    0, 0
+];
+
+
+def packconfig(config):
+    """Packs a radio configuration into bytes."""
+    return bytes(config);
+def stripnulls(msg):
+    """Strips a message to its first null terminator, as text."""
+    msg=msg.split(b'\0')[0].replace(b'\n',b'');
+    return msg.decode('latin-1').strip();
+
+
+
+class SerialTransport:
+    """A GoodWatch on a serial port, through pyserial.  The RTS and
+    DTR lines of the usual adapter reach TST and !RST."""
+    # The watch's clock is slow before turbo mode, so pace our bytes.
+    paced=True;
+    def __init__(self, port, baud=9600, timeout=1):
+        import serial;
+        self.serial=serial.Serial(port,
+                                  baudrate=baud,
+                                  timeout=timeout);
+    def write(self,data):
+        self.serial.write(data);
+    def read(self,length):
+        """Reads up to length bytes, fewer on a timeout."""
+        return self.serial.read(length);
+    def flushinput(self):
+        self.serial.reset_input_buffer();
+    def setbaud(self,baud):
+        self.serial.baudrate=baud;
+    def settimeout(self,timeout):
+        self.serial.timeout=timeout;
+
+    def setTST(self,level):
+        """Sets the TST pin."""
+        self.serial.rts=level;
+        time.sleep(0.01);
+    def setRST(self,level):
+        """Sets the !RST pin."""
+        self.serial.dtr=level;
+        time.sleep(0.01);
+    def reset(self):
+        """Exits the BSL by resetting the chip, then releases it."""
+        self.setTST(True)
+        self.setRST(True);
+        self.setRST(False);
+        self.setRST(True);
+        self.setRST(False);
+        time.sleep(1);
+        self.setRST(False);
+
+class FileTransport:
+    """A GoodWatch behind a file descriptor, such as the master or
+    slave side of a pseudo-terminal.  There's no baud rate here, so
+    nothing needs pacing, but a terminal is told our rate anyway, so
+    that watchemu can tell when we disagree with the watch."""
+    paced=False;
+    def __init__(self, path=None, fd=None, timeout=1):
+        import termios, tty;
+        if fd==None:
+            fd=os.open(path, os.O_RDWR|os.O_NOCTTY);
+        if os.isatty(fd):
+            tty.setraw(fd, termios.TCSANOW);
+        self.fd=fd;
+        self.timeout=timeout;
+        self.setbaud(9600);
+    def close(self):
+        os.close(self.fd);
+    def write(self,data):
+        while data:
+            data=data[os.write(self.fd,data):];
+    def read(self,length):
+        """Reads up to length bytes, fewer on a timeout."""
+        import select;
+        data=b'';
+        deadline=time.time()+self.timeout;
+        while len(data)<length:
+            left=deadline-time.time();
+            if left<=0 or not select.select([self.fd],[],[],left)[0]:
+                break;
+            data+=os.read(self.fd,length-len(data));
+        return data;
+    def flushinput(self):
+        import select;
+        while select.select([self.fd],[],[],0)[0]:
+            if not os.read(self.fd,4096):
+                break;
+    def setbaud(self,baud):
+        import termios;
+        if not os.isatty(self.fd):
+            return;
+        attrs=termios.tcgetattr(self.fd);
+        attrs[4]=attrs[5]=getattr(termios,"B%d"%baud);
+        termios.tcsetattr(self.fd, termios.TCSANOW, attrs);
+    def settimeout(self,timeout):
+        self.timeout=timeout;
+
+class SocketTransport:
+    """A GoodWatch behind a TCP socket, such as ser2net or an
+    emulator."""
+    paced=False;
+    def __init__(self, host, port, timeout=1):
+        self.sock=socket.create_connection((host,port));
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1);
+        self.timeout=timeout;
+    def write(self,data):
+        self.sock.sendall(data);
+    def read(self,length):
+        """Reads up to length bytes, fewer on a timeout."""
+        data=b'';
+        deadline=time.time()+self.timeout;
+        while len(data)<length:
+            left=deadline-time.time();
+            if left<=0:
+                break;
+            self.sock.settimeout(left);
+            try:
+                chunk=self.sock.recv(length-len(data));
+            except socket.timeout:
+                break;
+            if not chunk:
+                break;
+            data+=chunk;
+        return data;
+    def flushinput(self):
+        self.sock.setblocking(False);
+        try:
+            while self.sock.recv(4096):
+                pass;
+        except (BlockingIOError, socket.error):
+            pass;
+        self.sock.setblocking(True);
+    def setbaud(self,baud):
+        pass;
+    def settimeout(self,timeout):
+        self.timeout=timeout;
+
+def opentransport(name, timeout=1):
+    """Opens a transport by name: tcp:host:port for a socket,
+    pty:/dev/pts/N for a pseudo-terminal, or else a serial port."""
+    if name.startswith("tcp:"):
+        (host,port)=name[4:].rsplit(":",1);
+        return SocketTransport(host,int(port),timeout);
+    if name.startswith("pty:"):
+        return FileTransport(name[4:],timeout=timeout);
+    return SerialTransport(name,timeout=timeout);
+
+
+
+class Request:
+    """A command that has been sent, and later its reply."""
+    def __init__(self,msg):
+        self.msg=msg;
+        self.reply=None;
+        self.done=False;
+
+class GoodWatch:
+    """Client of the UART monitor.  Commands may be submitted without
+    waiting for their replies, and up to WINDOW of them stay in flight
+    at once.  Replies come back in order, so each is matched to the
+    oldest command still waiting.
+
+    A reply that is lost, damaged or refused costs a resend of every
+    command in flight, which the watch will run again.  That's
+    harmless for everything but RADIOTX, which will transmit twice."""
+
+    def __init__(self, transport, window=WINDOW, tries=3):
+        if isinstance(transport,str):
+            transport=opentransport(transport);
+        self.transport=transport;
+        self.window=window;
+        self.tries=tries;
+        self.inflight=collections.deque();
+        #Sniffer records that arrived while we were waiting on a reply.
+        self.sniffing=False;
+        self.sniffqueue=collections.deque();
+
+    def reset(self):
+        """Resets the watch, if the transport can."""
+        if hasattr(self.transport,"reset"):
+            self.transport.reset();
+            return True;
+        return False;
+
+    def frame(self,msg):
+        """Wraps a message with a prefix and checksum."""
+        length=len(msg);
+        return bytes([0x80])+chr16(length)+msg+chr16(crc16(msg));
+    def readexact(self,length):
+        """Reads exactly length bytes, or raises IOError.  Slow
+        replies are fine, so long as they keep coming."""
+        data=b'';
+        while len(data)<length:
+            chunk=self.transport.read(length-len(data));
+            if not chunk:
+                raise IOError("Timeout after %d of %d bytes." % (len(data),length));
+            data+=chunk;
+        return data;
+    def readframe(self,patient=False):
+        """Reads one framed reply from the watch, stripping the wrapper.
+        Raises IOError on a NAK, a bad checksum or a timeout, except
+        that a patient read returns None when nothing arrives at all."""
+        while True:
+            first=self.transport.read(1);
+            if not first:
+                if patient:
+                    return None;
+                raise IOError("Missing reply.");
+            if first[0]!=0x00:
+                raise IOError("Watch replied 0x%02x, %s." % (
+                    first[0], NAKS.get(first[0],"unknown error")));
+            header=self.readexact(3);
+            if header[0]!=0x80:
+                raise IOError("Bad frame header 0x%02x." % header[0]);
+            rep=self.readexact(ord16(header[1:3]));
+            crc=self.readexact(2);
+            if ord16(crc)!=crc16(rep):
+                raise IOError("Bad CRC in reply.");
+            if (self.sniffing and len(rep)>=SNIFFHEADER
+                and rep[0]==RADIOSNIFF):
+                #A sniffer record, not the reply that we're after.
+                self.sniffqueue.append((time.time(),rep));
+                if patient:
+                    return rep;
+                continue;
+            return rep;
+
+    def submit(self,msg):
+        """Sends a command without waiting for its reply, unless the
+        window is full.  Returns a Request for result()."""
+        while len(self.inflight)>=self.window:
+            self.complete();
+        req=Request(msg);
+        self.inflight.append(req);
+        self.transport.write(self.frame(msg));
+        return req;
+    def complete(self):
+        """Waits for the reply to the oldest command in flight,
+        resending everything in flight when something goes wrong."""
+        req=self.inflight[0];
+        for i in range(self.tries):
+            try:
+                req.reply=self.readframe();
+                req.done=True;
+                self.inflight.popleft();
+                return req;
+            except IOError as e:
+                error=e;
+            #Let the watch finish whatever it was saying, then resend.
+            time.sleep(0.1);
+            self.transport.flushinput();
+            for r in self.inflight:
+                self.transport.write(self.frame(r.msg));
+        self.inflight.clear();
+        raise IOError("Giving up on 0x%02x after %d tries: %s" % (
+            req.msg[0], self.tries, error));
+    def result(self,req):
+        """Returns the reply to a submitted command."""
+        while not req.done:
+            self.complete();
+        return req.reply;
+    def sync(self):
+        """Waits until no commands are in flight."""
+        while self.inflight:
+            self.complete();
+    def transact(self,msg):
+        """Sends a command and returns its reply."""
+        return self.result(self.submit(msg));
+
+    def turbomode(self,enable=1):
+        """Enable turbo mode.  Over a real serial port, we have to do
+        this slowly because the chip is running slowly."""
+        self.sync();
+        if not self.transport.paced:
+            return self.transact(bytes([SETTURBOMODE,enable]));
+        for byte in b"\x00"+self.frame(bytes([SETTURBOMODE,enable])):
+            self.transport.write(bytes([byte]));
+            time.sleep(0.2);
+        try:
+            return self.readframe();
+        except IOError:
+            return None;
+    def setbaud(self,baud):
+        """Switches the monitor link to a faster baud rate, clocked
+        from the watch's DCO.  Returns True if the watch agreed."""
+        #The watch switches after its reply, so nothing else may be queued.
+        self.sync();
+        reply=self.transact(bytes([SETBAUD,0])+chr16(baud//100));
+        if len(reply)<2 or reply[1]!=1:
+            #Older firmware just echoes the command, so we stay put.
+            return False;
+        self.transport.setbaud(baud);
+        #Give the watch a moment to switch its clock.
+        time.sleep(0.05);
+        return True;
+    def peek(self,adr):
+        """Peeks a 16-bit word from memory."""
+        s=self.transact(bytes([PEEK,0])+chr16(adr));
+        return ord16(s[2:4]);
+    def poke(self,adr,val):
+        """Pokes a 16-bit word into memory."""
+        self.transact(bytes([POKE,0])+chr16(adr)+chr16(val));
+    def read(self,adr,length):
+        """Reads a block of memory, with a frame in flight while the
+        last one comes back."""
+        reqs=[];
+        for i in range(0,length,READMAX):
+            n=min(READMAX,length-i);
+            reqs.append((adr+i,n,self.submit(bytes([READ,0])+chr16(adr+i)+chr16(n))));
+        data=b'';
+        for (a,n,req) in reqs:
+            chunk=self.result(req);
+            if len(chunk)!=n:
+                raise IOError("Short read at 0x%04x." % a);
+            data+=chunk;
+        return data;
+    def write(self,adr,data,verify=True):
+        """Writes a block of memory, a frame at a time, then reads it
+        all back to be sure that it landed."""
+        n=UARTBUFLEN-4;
+        for i in range(0,len(data),n):
+            self.submit(bytes([WRITE,0])+chr16(adr+i)+data[i:i+n]);
+        self.sync();
+        if verify:
+            back=self.read(adr,len(data));
+            for i in range(len(data)):
+                if back[i]!=data[i]:
+                    raise IOError("Verify failed at 0x%04x." % (adr+i));
+    def lcdstring(self,string):
+        """Writes an 8-letter string to the LCD."""
+        if isinstance(string,str):
+            string=string.encode('latin-1');
+        self.transact(bytes([LCDSTRING])+string+b"\x00");
+    def dmesg(self):
+        """Returns the whole dmesg buffer."""
+        return self.transact(bytes([DMESG]));
+    def dmesgsince(self,epoch=0,seq=0):
+        """Returns the epoch, sequence number and text of dmesg
+        characters from seq onward.  The text begins earlier than seq
+        if the buffer wrapped or was cleared."""
+        reply=self.transact(bytes([DMESG,0])+chr16(epoch)+chr16(seq)+chr16(seq>>16));
+        epoch=ord16(reply[2:4]);
+        seq=ord16(reply[4:6])|(ord16(reply[6:8])<<16);
+        return (epoch,seq,reply[8:]);
+    def dmesgfollow(self,interval=0.5):
+        """Yields new dmesg text forever, like tail -f.  Gaps are
+        yielded as a note in the text."""
+        epoch=0;
+        seq=0;
+        while True:
+            (newepoch,start,text)=self.dmesgsince(epoch,seq);
+            if newepoch!=epoch and seq>0:
+                yield "\n---- dmesg was cleared ----\n";
+            elif start>seq:
+                yield "\n---- %d characters lost ----\n" % (start-seq);
+            yield text.replace(b"\0",b"").decode('latin-1');
+            epoch=newepoch;
+            seq=start+len(text);
+            #A full frame means there's more waiting, so don't sleep.
+            if len(text)<UARTBUFLEN-8:
+                time.sleep(interval);
+    def randint(self,count):
+        """Returns count random 16bit integers."""
+        reqs=[];
+        while count>0:
+            n=min(UARTBUFLEN//2,count);
+            reqs.append((n,self.submit(bytes([RANDINT,0])+chr16(n))));
+            count-=n;
+        samples=();
+        for (n,req) in reqs:
+            samples+=struct.unpack("<"+"H"*n,self.result(req)[:2*n]);
+        return samples;
+
+    def radioonoff(self,on=1):
+        """Turns the radio on or off."""
+        return self.transact(bytes([RADIOONOFF,on]));
+    def radioconfig(self,configuration):
+        """Configures the radio, from bytes or a list of pairs."""
+        if isinstance(configuration,list):
+            configuration=packconfig(configuration);
+        return self.transact(bytes([RADIOCONFIG])+configuration);
+    def radiofreq(self,freq):
+        """Sets the radio frequency in MHz."""
+        freqMult = (0x10000 / 1000000.0) / 26.0;
+        num=int(freq*1e6*freqMult);
+        freq2=(num>>16) & 0xFF;
+        freq1=(num>> 8) & 0xFF;
+        freq0= num      & 0xFF
+        return self.radioconfig([
+            FREQ2, freq2,
+            FREQ1, freq1,
+            FREQ0, freq0,
+            0, 0
+        ]);
+    def radiorx(self):
+        """Returns the last packet heard on the current channel."""
+        return self.transact(bytes([RADIORX]));
+    def radiotx(self,message,length=32):
+        """Sends a radio packet on the current frequency."""
+        message=message[0:length].ljust(length,b'\x00');
+        return self.transact(bytes([RADIOTX])+message);
+    def radiosniff(self,on=1):
+        """Starts or stops pushing every received packet to us."""
+        if on:
+            self.sniffing=True;
+            self.sniffqueue.clear();
+        #Records may arrive ahead of the reply, but they're routed aside.
+        reply=self.transact(bytes([RADIOSNIFF,on]));
+        if not on:
+            self.sniffing=False;
+        return reply;
+    def sniffrecords(self):
+        """Yields a dictionary for each record of the sniffer stream."""
+        lastseq=0;
+        while True:
+            if not self.sniffqueue:
+                try:
+                    self.readframe(patient=True);
+                except IOError as e:
+                    print(e);
+                continue;
+            (hosttime,rep)=self.sniffqueue.popleft();
+            (seq,rssi,lqi,hour,minute,sec,ticks)=struct.unpack("<HBBBBBB",rep[2:10]);
+            if rssi>=128:
+                rssi-=256;
+            record={
+                "seq": seq,
+                "lost": (seq-lastseq-1)&0xFFFF,
+                "hosttime": hosttime,
+                "watchtime": "%02d:%02d:%02d.%03d" % (hour,minute,sec,ticks*1000//128),
+                "rssi": rssi/2.0-74,      #dBm, per the CC1101 datasheet.
+                "lqi": lqi&0x7F,
+                "crcok": (lqi&0x80)!=0,
+                "data": rep[SNIFFHEADER:]
+            };
+            lastseq=seq;
+            yield record;
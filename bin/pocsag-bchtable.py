@@ -0,0 +1,42 @@
+#!/usr/bin/python3
+
+## This generates the syndrome table used by firmware/libs/pocsag.c
+## to correct one or two bit errors in a POCSAG codeword.  Paste its
+## output over the table in that file if the layout ever changes.
+
+import sys;
+
+#Generator polynomial of BCH(31,21), x^10+x^9+x^8+x^6+x^5+x^3+1.
+G=0x769;
+
+def syndrome(codeword):
+    """Returns the 10-bit remainder of a 31-bit codeword."""
+    for i in range(30,9,-1):
+        if codeword&(1<<i):
+            codeword^=G<<(i-10);
+    return codeword;
+
+#Syndrome of a single error at each bit position.
+syns=[syndrome(1<<i) for i in range(31)];
+
+#Each syndrome maps to the lowest bit in error, or 0xFF if hopeless.
+table=[0xFF]*1024;
+for i in range(31):
+    table[syns[i]]=i;
+for i in range(31):
+    for j in range(i+1,31):
+        s=syns[i]^syns[j];
+        assert(table[s]==0xFF);
+        table[s]=i;
+
+sys.stdout.write("//! Syndrome of a single bit error at each position.\n");
+sys.stdout.write("static const uint16_t pocsag_bchsyndromes[31]={\n");
+for i in range(0,31,8):
+    sys.stdout.write("  "+" ".join("0x%03x,"%s for s in syns[i:i+8])+"\n");
+sys.stdout.write("};\n\n");
+
+sys.stdout.write("//! Lowest errored bit for each syndrome, 0xFF if uncorrectable.\n");
+sys.stdout.write("static const uint8_t pocsag_bchtable[1024]={\n");
+for i in range(0,1024,16):
+    sys.stdout.write("  "+",".join("0x%02x"%t for t in table[i:i+16])+",\n");
+sys.stdout.write("};\n");
@@ -3,12 +3,16 @@
 ## Quick little pyelftools script to test the size of a CC430F6137
 ## firmware image, warning the user if it looks too big.
 
-from __future__ import print_function
-import sys
-
+## With --json, it also attributes every symbol to the source file
+## that defined it, then sums them by module, by applet and for the
+## larger ROM tables.  A --baseline report from an earlier build
+## makes it fail when Flash or RAM grows by more than --threshold
+## percent, where RAM counts .noinit and the applets' .overlay along
+## with .data and .bss.  That part uses binutils rather than pyelftools, because
+## nm -l can find the source of a function even after LTO.
 
-from elftools.elf.elffile import ELFFile
-from elftools.elf.sections import SymbolTableSection
+from __future__ import print_function
+import sys, os, re, json, argparse, subprocess
 
 
 def process_file(filename):
@@ -18,6 +22,7 @@ def process_file(filename):
 
 
 def printsizes(stream):
+    from elftools.elf.elffile import ELFFile
     elffile = ELFFile(stream);
 
     
@@ -43,15 +48,194 @@ def printsizes(stream):
     noinit=elffile.get_section_by_name('.noinit');
     if noinit!=None:
         noinitlen=len(noinit.data());
-    dataperc=(datalen+bsslen+noinitlen)*100.0/4096;
+    #Applets share the overlay, so its size is their high-water mark.
+    overlaylen=0;
+    overlay=elffile.get_section_by_name('.overlay');
+    if overlay!=None:
+        overlaylen=overlay['sh_size'];
+    dataperc=(datalen+bsslen+noinitlen+overlaylen)*100.0/4096;
 
-    if datalen+bsslen+noinitlen>0:
+    if datalen+bsslen+noinitlen+overlaylen>0:
         print("\t%d bytes of .data, %d bytes of .bss, %d bytes of .noinit (%d%% RAM)"
               %(datalen,bsslen,noinitlen,dataperc));
+        print("\t%d bytes of .overlay, the most that any one applet claims"
+              %overlaylen);
     if dataperc>80:
         print("WARNING: %d percent of data is used!"%dataperc);
 
 
+
+## Symbols are attributed to these kinds of memory by their section.
+## Initialized data costs both Flash for its image and RAM.
+def kindsof(section):
+    """Returns the kinds of memory that a section occupies."""
+    if section.startswith('.noinit'):
+        return ['noinit'];
+    if section.startswith('.overlay'):
+        return ['overlay'];
+    if 'bss' in section:
+        return ['ram'];
+    if 'rodata' in section:
+        return ['flash'];
+    if 'data' in section:
+        return ['flash','ram'];
+    if 'text' in section or section.startswith('.vectors') or section.startswith('__interrupt'):
+        return ['flash'];
+    return [];
+KINDS=['flash','ram','noinit','overlay'];
+## The growth gate sums these kinds, because all of them are RAM.
+GATES=[('flash',['flash']), ('ram',['ram','noinit','overlay'])];
+
+def run(args):
+    """Returns the output of a command as lines."""
+    return subprocess.check_output(args,universal_newlines=True).splitlines();
+
+def symbolsof(filename, prefix):
+    """Returns (name, address, section, size) of every sized symbol."""
+    symbols=[];
+    for line in run([prefix+'objdump','-t',filename]):
+        m=re.match(r'^([0-9a-f]+) .{7} (\S+)\t([0-9a-f]+)\s+(?:\.hidden\s+)?(\S+)$',line);
+        if m and int(m.group(3),16)>0:
+            symbols.append((m.group(4),int(m.group(1),16),m.group(2),int(m.group(3),16)));
+    return symbols;
+
+def filesof(filename, prefix):
+    """Returns a dictionary of source files by (name, address), from nm -l."""
+    files={};
+    for line in run([prefix+'nm','-l','--defined-only',filename]):
+        m=re.match(r'^([0-9a-f]+) \S (\S+)\t(.*):[0-9?]+$',line);
+        if m:
+            files[(m.group(2),int(m.group(1),16))]=m.group(3);
+    return files;
+
+def definitions(root):
+    """Returns a dictionary of source files by the file-scope names that
+    they define, for data that nm can't place after LTO.  A name
+    defined in more than one file maps to None."""
+    defs={};
+    for dirpath,dirnames,filenames in os.walk(root):
+        dirnames[:]=[d for d in dirnames if d!='host'];
+        for f in filenames:
+            if not f.endswith('.c') and not f.endswith('.h'):
+                continue;
+            path=os.path.join(dirpath,f);
+            for line in open(path,errors='replace'):
+                #Definitions begin in the first column and have no parens before the name.
+                m=re.match(r'^(?!extern|typedef|#)[A-Za-z_][^(;=]*?\b([A-Za-z_]\w*)\s*(\[[^\]]*\])*\s*(=|;|\{|$)',line);
+                if m:
+                    name=m.group(1);
+                    defs[name]=path if defs.get(name,path)==path else None;
+    return defs;
+
+def modulename(path, root):
+    """Returns a source path relative to the firmware directory."""
+    rel=os.path.relpath(os.path.normpath(path),root);
+    if rel.startswith('..'):
+        return os.path.basename(path);
+    return rel;
+
+def attribute(filename, prefix='msp430-elf-'):
+    """Returns a report of memory use by module, applet and table."""
+    root=os.path.dirname(os.path.abspath(filename));
+    files=filesof(filename,prefix);
+    defs=None;
+    report={'totals':dict((k,0) for k in KINDS),
+            'modules':{}, 'applets':{}, 'tables':{}};
+
+    #Totals come from the sections, so padding and startup code count.
+    for line in run([prefix+'size','-A',filename]):
+        fields=line.split();
+        if len(fields)==3 and fields[1].isdigit():
+            for kind in kindsof(fields[0]):
+                report['totals'][kind]+=int(fields[1]);
+
+    for name,adr,section,size in symbolsof(filename,prefix):
+        kinds=kindsof(section);
+        if not kinds:
+            continue;
+        source=files.get((name,adr));
+        if source==None:
+            #LTO renames statics as name.lto_priv.0 or name.1234.
+            if defs==None:
+                defs=definitions(root);
+            source=defs.get(name.split('.')[0]);
+        module=modulename(source,root) if source else '(unknown)';
+        entry=report['modules'].setdefault(module,dict((k,0) for k in KINDS));
+        for kind in kinds:
+            entry[kind]+=size;
+        if module.startswith('apps/'):
+            applet=os.path.splitext(os.path.basename(module))[0];
+            entry=report['applets'].setdefault(applet,dict((k,0) for k in KINDS));
+            for kind in kinds:
+                entry[kind]+=size;
+        #Tables are big constants, like fonts, words and radio settings.
+        if kinds==['flash'] and size>=32 and 'text' not in section:
+            report['tables'][name]={'module':module,'flash':size};
+
+    #Whatever is left over has no symbol.
+    attributed=dict((k,sum(m[k] for m in report['modules'].values())) for k in KINDS);
+    report['modules']['(unattributed)']=dict(
+        (k,report['totals'][k]-attributed[k]) for k in KINDS);
+    return report;
+
+def printreport(report):
+    """Prints the modules and applets, biggest first."""
+    for group in ('modules','applets'):
+        print("\t%-32s %6s %6s %6s %6s" % ((group,)+tuple(KINDS)));
+        for name,sizes in sorted(report[group].items(),
+                                 key=lambda i: -i[1]['flash']-i[1]['ram']):
+            print("\t%-32s %6d %6d %6d %6d" % ((name,)+tuple(sizes[k] for k in KINDS)));
+
+def compare(report, baseline, threshold):
+    """Prints what changed since the baseline.  Returns False if Flash
+    or RAM grew by more than threshold percent."""
+    ok=True;
+    for kind,kinds in GATES:
+        old=sum(baseline['totals'].get(k,0) for k in kinds);
+        new=sum(report['totals'][k] for k in kinds);
+        growth=(new-old)*100.0/old if old else 0;
+        print("\t%s: %d bytes, %+d since the baseline (%+.1f%%)" % (kind,new,new-old,growth));
+        if growth>threshold:
+            print("ERROR: %s grew by more than %.1f%%." % (kind,threshold));
+            ok=False;
+    for group in ('applets','modules'):
+        names=set(report[group])|set(baseline[group]);
+        for name in sorted(names):
+            new=report[group].get(name,{});
+            old=baseline[group].get(name,{});
+            deltas=[new.get(k,0)-old.get(k,0) for k in KINDS];
+            if any(deltas):
+                print("\t\t%-32s %s" % (name,
+                      " ".join("%s %+d" % (k,d) for k,d in zip(KINDS,deltas) if d)));
+    return ok;
+
 if __name__ == '__main__':
-    for filename in sys.argv[1:]:
-        process_file(filename)
+    parser=argparse.ArgumentParser(description='Firmware size report.');
+    parser.add_argument('files',nargs='+',help='ELF files to measure.');
+    parser.add_argument('-m','--modules',action='store_true',
+                        help='Print memory use by module and applet.');
+    parser.add_argument('--json',help='Write the attribution report here.');
+    parser.add_argument('--baseline',help='Compare to this earlier report.');
+    parser.add_argument('--threshold',type=float,default=1.0,
+                        help='Percent growth that fails the comparison.');
+    parser.add_argument('--prefix',default='msp430-elf-',
+                        help='Prefix of the binutils commands.');
+    args=parser.parse_args();
+
+    if not (args.modules or args.json or args.baseline):
+        for filename in args.files:
+            process_file(filename)
+        sys.exit(0);
+
+    #Attribution is for a single image.
+    report=attribute(args.files[0],args.prefix);
+    if args.modules:
+        printreport(report);
+    if args.json:
+        with open(args.json,'w') as f:
+            json.dump(report,f,indent=1,sort_keys=True);
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline=json.load(f);
+        if not compare(report,baseline,args.threshold):
+            sys.exit(1);
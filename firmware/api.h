@@ -31,6 +31,7 @@
 #include "power.h"
 #include "dmesg.h"
 #include "buzz.h"
+#include "battery.h"
 #include "descriptor.h"
 #include "githash.h" //Autogenerated
 
@@ -39,6 +40,14 @@
 #include "libs/morse.h"
 #include "libs/pocsag.h"
 #include "libs/phonebook.h"
+#include "libs/crc16.h"
+
+/* Numbers become pointers by way of this macro, so that host builds
+   can put the watch's address space somewhere they're allowed to.
+ */
+#ifndef MEMPTR
+#define MEMPTR(adr) ((void*) (adr))
+#endif
 
 //Standalone functions.
 
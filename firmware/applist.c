@@ -117,26 +117,30 @@ const struct app subapps[]={
 #ifdef TUNER_APP
   //Tuner Tool
   {.name="tuner", .init=tuner_init, .draw=tuner_draw, .exit=tuner_exit,
-   .keypress=tuner_keypress
+   .keypress=tuner_keypress,
+   .radio=1
   },
 #endif 
 #ifdef COUNTER_APP
   //Counter Tool
   {.name="counter", .init=counter_init, .draw=counter_draw, .exit=counter_exit,
-   .keypress=counter_keypress
+   .keypress=counter_keypress,
+   .radio=1
   },
 #endif 
 #ifdef MORSE_APP
   //Morse transmitter.
   {.name="morse", .init=morse_init, .draw=morse_draw, .exit=morse_exit,
-   .keypress=morse_keypress
+   .keypress=morse_keypress,
+   .radio=1
   },
 #endif
 #ifdef BEACON_APP
   //Beacon
   {.name="beacon",
    .init=beacon_init, .draw=beacon_draw, .exit=beacon_exit,
-   .packetrx=beacon_packetrx, .keypress=beacon_keypress
+   .packetrx=beacon_packetrx, .keypress=beacon_keypress,
+   .radio=1
   },
 #endif
 #ifdef OOK_APP
@@ -144,7 +148,8 @@ const struct app subapps[]={
   {.name="OOK",
    .init=ook_init, .draw=ook_draw, .exit=ook_exit,
    .packetrx=ook_packetrx, .packettx=ook_packettx,
-   .keypress=ook_keypress
+   .keypress=ook_keypress,
+   .radio=1
   },
 #endif
 
@@ -153,7 +158,8 @@ const struct app subapps[]={
   {.name="shaders",
    .init=shaders_init, .draw=shaders_draw, .exit=shaders_exit,
    .packetrx=shaders_packetrx, .packettx=shaders_packettx,
-   .keypress=shaders_keypress
+   .keypress=shaders_keypress,
+   .radio=1
   },
 #endif
 
@@ -163,7 +169,8 @@ const struct app subapps[]={
    .init=jukebox_init, .draw=jukebox_draw, .exit=jukebox_exit,
    .packetrx=jukebox_packetrx, .packettx=jukebox_packettx,
    .keypress=jukebox_keypress,
-   .fallthrough=jukebox_fallthrough
+   .fallthrough=jukebox_fallthrough,
+   .radio=1
   },
 #endif
 
@@ -172,7 +179,8 @@ const struct app subapps[]={
   //POCSAG Pager
   {.name="pager", .init=pager_init, .draw=pager_draw, .exit=pager_exit,
    .packetrx=pager_packetrx,
-   .keypress=pager_keypress
+   .keypress=pager_keypress,
+   .radio=1
   },
 #endif
 
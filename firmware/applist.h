@@ -47,3 +47,26 @@ extern const struct app apps[];
    the main menu once selected.
  */
 extern const struct app subapps[];
+
+/* Only one applet is active at a time, so applets that don't need
+   their variables between visits keep them here rather than in .bss.
+   The linker places this union in .overlay, which isn't zeroed at
+   boot; app_claim() zeroes it for each applet's init(), and
+   app_release() gives it up from exit().  app_next() and
+   app_forcehome() also release it as they leave an applet, so the
+   owner can't go stale.  State that must outlive a visit, such as
+   pager messages or rolling codes, stays in .bss.
+ */
+union app_overlay {
+  char none;
+#ifdef RPN_APP
+  struct rpn_state rpn;
+#endif
+#ifdef COUNTER_APP
+  struct counter_state counter;
+#endif
+#ifdef TUNER_APP
+  struct tuner_state tuner;
+#endif
+};
+extern union app_overlay app_overlay;
@@ -7,6 +7,7 @@
 
 #include <msp430.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "api.h"
 #include "applist.h"
@@ -20,6 +21,57 @@ static int idlecount=0;
 //! The currently selected application.
 const struct app *applet=&apps[DEFAULTAPP];
 
+//! Shared state of whichever applet is active.  See applist.h.
+union app_overlay app_overlay __attribute__ ((section (".overlay")));
+
+//! Applet holding the overlay, or null.
+static const struct app *overlay_owner=0;
+
+//! Claims the applet overlay from init(), zeroed as .bss would be.
+void app_claim(){
+  if(overlay_owner && overlay_owner!=applet)
+    printf("%s took the overlay from %s.\n",
+           applet->name, overlay_owner->name);
+  memset(&app_overlay, 0, sizeof(app_overlay));
+  overlay_owner=applet;
+}
+
+//! Releases the applet overlay from exit(), or as we leave an applet.
+void app_release(){
+  overlay_owner=0;
+}
+
+//! Starts or stops the WDT's quarter-second frames.
+void app_frames(int on){
+  if(on){
+    //250ms from ACLK, as an interval timer.
+    WDTCTL = WDT_ADLY_250;
+    SFRIE1 |= WDTIE;
+  }else{
+    //Nothing is drawn until the frames return.
+    SFRIE1 &= ~WDTIE;
+    WDTCTL = WDTPW + WDTHOLD;
+  }
+}
+
+//! Non-zero while the WDT's frames are running.
+int app_frameson(){
+  return SFRIE1 & WDTIE;
+}
+
+//! Draws the applet from the RTC's minute event if its frames are stopped.
+void app_minute(){
+  /* Applets that stop the frames to save power, such as the dozing
+     clock and Shabbat mode, are drawn only here.  They must keep the
+     idle timer clear, or they would be sent home after three minutes.
+   */
+  if(app_frameson())
+    return;
+  lcd_predraw();
+  app_draw(0);
+  lcd_postdraw();
+}
+
 //! Every 3 minutes we return to the clock unless this is called.
 void app_cleartimer(){
   idlecount=0;
@@ -28,6 +80,9 @@ void app_cleartimer(){
 //! Renders the current app to the screen.
 void app_draw(int forced){
   static int lastmin=0;
+#ifdef DMESG_MARKS
+  static const struct app *marked=0;
+#endif
   
   //If we go three minutes without action, return to main screen.
   if(lastmin!=RTCMIN){
@@ -42,10 +97,20 @@ void app_draw(int forced){
   //Draw the applet if it exists, or switch to the clock if we're at
   //the end of the list.  The draw is forced if it is drawn by a
   //keypress and not as a timer.
-  if(applet->draw)
+  if(applet->draw){
+#ifdef DMESG_MARKS
+    //Every switch is followed by a draw, so we mark it here.
+    if(marked!=applet){
+      marked=applet;
+      DMESG_MARK(DMESG_MARK_APP, applet->name);
+    }
+#endif
+    DMESG_MARK(DMESG_MARK_DRAW, 0);
     applet->draw(forced);
-  else
+    DMESG_MARK(DMESG_MARK_DRAWN, 0);
+  }else{
     app_forcehome();
+  }
   return;
 }
 
@@ -54,6 +119,8 @@ void app_forcehome(){
   //First we try to exit politely.
   if(applet->exit)
     applet->exit();
+  //The overlay is given up even if exit() refused, or forgot to.
+  app_release();
 
   //And force it if that doesn't work.
   appindex=0;  //Move to the clock applet, not settime.
@@ -102,6 +169,8 @@ void app_next(){
   //Return if there is an exit function and it returns non-zero.
   if(applet->exit && applet->exit())
     return;
+  //An applet without an exit() can't give up the overlay itself.
+  app_release();
   
   applet = &apps[++appindex];
   if(!applet->draw){
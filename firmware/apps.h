@@ -46,6 +46,11 @@ struct app {
   void (*packetrx)(uint8_t *packet, int len); //A packet has arrived.
   void (*packettx)(void); //A packet has been sent.
 
+  /* Non-zero if the applet uses the radio, which it may not do on a
+     low battery.  See battery.c.
+   */
+  int radio;
+
 };
 
 
@@ -67,6 +72,18 @@ void app_packettx();
 //! Handles a keypress, if a handler is registered.
 void app_keypress(char ch);
 
+//! Starts or stops the WDT's quarter-second frames.
+void app_frames(int on);
+//! Non-zero while the WDT's frames are running.
+int app_frameson();
+//! Draws the applet from the RTC's minute event if its frames are stopped.
+void app_minute();
+
+//! Claims the applet overlay from init(), zeroed as .bss would be.
+void app_claim();
+//! Releases the applet overlay from exit(), or as we leave an applet.
+void app_release();
+
 //! Sets an app by a pointer to its structure.  Used for submenus.
 void app_set(const struct app *newapplet);
 //! Sets back to the indexed app.  Does not work in the submenu.
@@ -11,6 +11,14 @@
   for the git tag, 5 for the date of flashing, 6 to toggle the CPU
   load indicator, 0 for the name of the current working channel.
   Hold 1 for the voltage, * for the CPU model number.
+
+  When CLOCKMINUTES is set in config.h, or the battery is low, the
+  clock dozes after CLOCKAWAKE seconds without a key.  The seconds are
+  blanked and the WDT's frames are stopped, so that the only wakeup is
+  the RTC's minute event, which draws the hours and minutes by way of
+  app_minute().  Any key wakes the clock back up, and so does the
+  falling edge of either side button, after which the button is
+  polled in the frames as usual.
 */
 
 #include <msp430.h>
@@ -35,8 +43,28 @@ static unsigned int vcc;
 //! This hold the last character pressed.
 static char lastchar=0;
 
-//! Draws the time.
-void draw_time(int always){
+//! Non-zero while dozing between minutes, without frames.
+static int dozing=0;
+//! Seconds left before the clock dozes.
+static int awake=0;
+
+//! Should the clock doze when left alone?
+static int clock_dozes(){
+  return CLOCKMINUTES || battery_low;
+}
+
+//! Wakes the clock for a while, bringing back the frames if dozing.
+static void clock_wake(){
+  awake=CLOCKAWAKE;
+  if(dozing){
+    dozing=0;
+    sidebutton_disarm();
+    app_frames(1);
+  }
+}
+
+//! Draws the time, blanking the seconds if they won't be kept up.
+void draw_time(int always, int blank){
   /* So at first glance, this might seem a bit complicated.  Why draw
      the seconds first, and why take so many opportunities to abort
      and return without drawing anything?
@@ -69,16 +97,34 @@ void draw_time(int always){
   unsigned int hour=RTCHOUR;
   static unsigned int min;
   static unsigned int sec;
+  static int dim;
   unsigned int lsec; //Lower digit of the seconds.
 
-  //Only draw once a second, unless a button is pressed.
-  if(sec==RTCSEC && !always)
-    return;
-  sec=RTCSEC;
-  lcd_digit(0,lsec=int2bcd(sec)&0xf); //Lower digit.
-  if(lsec && !always)  //Only need to draw tens digit if ones is zero.
-    return;
-  lcd_digit(1,int2bcd(sec)>>4);
+  /* Callers without frames pass blank, and a low battery hides the
+     seconds for everyone.  A change redraws everything.
+   */
+  blank|=battery_low;
+  if(dim!=blank){
+    dim=blank;
+    always=1;
+  }
+
+  if(dim){
+    //The seconds are blank, and the rest changes once a minute.
+    if(min==RTCMIN && !always)
+      return;
+    lcd_cleardigit(0);
+    lcd_cleardigit(1);
+  }else{
+    //Only draw once a second, unless a button is pressed.
+    if(sec==RTCSEC && !always)
+      return;
+    sec=RTCSEC;
+    lcd_digit(0,lsec=int2bcd(sec)&0xf); //Lower digit.
+    if(lsec && !always)  //Only need to draw tens digit if ones is zero.
+      return;
+    lcd_digit(1,int2bcd(sec)>>4);
+  }
   
 
   //If the minute hasn't changed, don't bother drawing it or the hour.
@@ -185,6 +231,19 @@ void clock_playtime(int hold){
 
 //! Draws the clock face in the main application.
 void clock_draw(int forced){
+  //While dozing, we are only drawn by the RTC's minute event.
+  if(dozing){
+    //Frameless applets are as thrifty as it gets, so needn't time out.
+    app_cleartimer();
+    if(clock_dozes() && !app_frameson()){
+      draw_time(0, 1);
+      return;
+    }
+
+    //A side button or a recovered battery brings the frames back.
+    clock_wake();
+  }
+
   //Use the SET button to reconfigure the time.
   if(sidebutton_set()){
     //Wait for the button to be released.
@@ -195,9 +254,17 @@ void clock_draw(int forced){
   
   if(!lastchar){
     // Draw the time by default, but only if no buttons pushed.
-    draw_time(redraw);
+    draw_time(redraw, 0);
     if(redraw)
       redraw--;
+
+    //Left alone for long enough, we doze until a key is pressed.
+    if(clock_dozes() && awake--<=0){
+      dozing=1;
+      sidebutton_arm(BIT5|BIT6);
+      app_frames(0);
+      draw_time(1, 1);
+    }
   }
 }
 
@@ -206,8 +273,9 @@ void clock_draw(int forced){
 void clock_init(){
   lastchar=0;
   redraw=0;
+  clock_wake();
   lcd_zero();
-  draw_time(1);
+  draw_time(1, 0);
 }
 
 
@@ -216,6 +284,9 @@ void clock_init(){
 int clock_keypress(char ch){
   lastchar=ch;
 
+  //Any key wakes the clock for a while.
+  clock_wake();
+
   /* This function is called *once* per keypress event, while the
      handlers in clock_draw() are called once per frame.  It is very
      important that anything that takes more than a frame be handled
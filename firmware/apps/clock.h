@@ -15,8 +15,8 @@ int clock_keypress(char ch);
 //! Plays the time as audio.
 void clock_playtime(int hold);
 
-//! Draw the time.
-void draw_time(int redraw);
+//! Draw the time, blanking the seconds if they won't be kept up.
+void draw_time(int redraw, int blank);
 //! Draw the date.
 void draw_date();
 
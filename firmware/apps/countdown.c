@@ -241,7 +241,7 @@ void countdown_draw(int forced){
   }
 
   if (showtime) {
-    draw_time(1);
+    draw_time(1, 0);
     return;
   }
 
@@ -37,6 +37,7 @@
 #include<string.h>
 #include<msp430.h>
 #include "api.h"
+#include "applist.h"
 
 
 /* Settings were prototyped first in Python.  This is basic OOK with
@@ -81,13 +82,13 @@ static const uint8_t counter_settings[]={
 /* This enum manages the state machine for the frequency counter.  The
    state will be IDLE before and after the sweep.
  */
-static enum {IDLE, SWEEP} counter_state;
-static int best_rssi;
-static float best_freq;
+enum {IDLE, SWEEP};
 #define MAX_BIGFREQ  470000000.0  //Range is 410 to 470 for now.
 #define MIN_BIGFREQ  410000000.0  //Will open more bands later.
 #define BIGSTEP_FREQ    100000.0  //100kHz/Step
-static float current_freq;
+
+//! Sweep state, in the applet overlay while we're active.
+static struct counter_state *const s=&app_overlay.counter;
 
 //! Try a given frequency, and update display if it's best.
 static void try_freq(float freq){
@@ -100,9 +101,9 @@ static void try_freq(float freq){
   rssi=radio_getrssi();
 
   //Compare it.
-  if(rssi>best_rssi){
-    best_rssi=rssi;
-    best_freq=freq;
+  if(rssi>s->best_rssi){
+    s->best_rssi=rssi;
+    s->best_freq=freq;
   }
 
 }
@@ -112,17 +113,17 @@ static void try_freq(float freq){
 //! Try the next frequency in the wide set.
 static void try_nextbig(){
   //Enforce the range here.
-  if(current_freq<MIN_BIGFREQ)
-    current_freq=MIN_BIGFREQ;
+  if(s->current_freq<MIN_BIGFREQ)
+    s->current_freq=MIN_BIGFREQ;
 
   //Try the next center freq and step ahead.
-  try_freq(current_freq);
-  current_freq+=BIGSTEP_FREQ;
+  try_freq(s->current_freq);
+  s->current_freq+=BIGSTEP_FREQ;
 
   //We're done!
-  if(current_freq>MAX_BIGFREQ){
-    current_freq=MIN_BIGFREQ;
-    counter_state=IDLE;
+  if(s->current_freq>MAX_BIGFREQ){
+    s->current_freq=MIN_BIGFREQ;
+    s->state=IDLE;
   }
 }
 
@@ -132,13 +133,14 @@ void counter_init(){
      We ignore the codeplug frequency and set our own.
    */
   if(has_radio){
+    app_claim();
     radio_on();
     radio_writesettings(counter_settings);
 
     //Initialize state variables.
-    counter_state=IDLE;
-    best_rssi=0;
-    best_freq=0;
+    s->state=IDLE;
+    s->best_rssi=0;
+    s->best_freq=0;
   }else{
     app_next();
   }
@@ -148,6 +150,7 @@ void counter_init(){
 int counter_exit(){
   //Cut the radio off and drop the CPU frequency.
   radio_off();
+  app_release();
   
   //Allow the exit.
   return 0;
@@ -155,7 +158,7 @@ int counter_exit(){
 
 //! Draw the counter's status.
 static void counter_drawstatus(){
-  lcd_number(current_freq/10);
+  lcd_number(s->current_freq/10);
 }
 
 
@@ -163,12 +166,12 @@ static void counter_drawstatus(){
 void counter_draw(){
   static int i, rssi;
   
-  switch(counter_state){
+  switch(s->state){
   case IDLE:
-    if(best_rssi==0)
+    if(s->best_rssi==0)
       lcd_string("CNT IDLE");
     else{
-      lcd_number(best_freq/10);
+      lcd_number(s->best_freq/10);
 
       /* Every other frame, we grab the signal strength.  Highest
 	 stays. */
@@ -217,26 +220,26 @@ int counter_keypress(char ch){
    */
   switch(ch){
   case '0': //Begin a new broad sweep.
-    best_rssi=0;
+    s->best_rssi=0;
     
   case '1': //Second pass of the broad sweep sweep.
-    counter_state=SWEEP;
-    current_freq = MIN_BIGFREQ;
+    s->state=SWEEP;
+    s->current_freq = MIN_BIGFREQ;
     
     //Do the sweep.
-    while(counter_state==SWEEP){
+    while(s->state==SWEEP){
       try_nextbig();
       //Draw every 64th channel.
       if((i++&0x3f)==0)
 	counter_drawstatus();
     }
     //Return to best freq on idle.
-    radio_setfreq(best_freq);
+    radio_setfreq(s->best_freq);
 
     break;
 
   case '=': //Copy best freq to VFO.
-    codeplug_setvfofreq(best_freq);
+    codeplug_setvfofreq(s->best_freq);
     break;
   }
   return 0;
@@ -2,6 +2,14 @@
   \brief Frequency Counter Application
 */
 
+//! Sweep state, kept in the applet overlay.
+struct counter_state {
+  int state;
+  int best_rssi;
+  float best_freq;
+  float current_freq;
+};
+
 //! Enter the Counter application.
 void counter_init();
 
@@ -61,6 +61,10 @@ int dmesgapp_keypress(char ch){
   case '0':// Press 0 to return to the start of the buffer.
     dispindex=0;
     break;
+  case '=':// Press = to report the clock governor's totals, and read them.
+    dispindex=dmesg_index;
+    ucs_report();
+    break;
   }
 
   //Force a redraw out-of-frame.
@@ -13,6 +13,7 @@
 */
 
 #include <stdint.h>
+#include <stdio.h>
 
 #include "api.h"
 #include "applist.h"
@@ -118,7 +119,7 @@ void hebrew_draw(){
   
   //Draw the time, usually.
   if(!lastchar)
-    draw_time(1);
+    draw_time(1, 0);
 }
 
 //! Keypress handler for the hebrew applet.
@@ -65,9 +65,9 @@ int hex_keypress(char ch){
   case '4':// Hold 4 to disassemble the curent instruction.
     lcd_zero();
     asm_dis(adr,
-	      ((unsigned int*)adr)[0],
-	      ((unsigned int*)adr)[1],
-	      ((unsigned int*)adr)[2]);
+	      ((unsigned int*) MEMPTR(adr))[0],
+	      ((unsigned int*) MEMPTR(adr))[1],
+	      ((unsigned int*) MEMPTR(adr))[2]);
     asm_show();
     return 0;  //We'll redraw when the button is released.
     
@@ -139,7 +139,7 @@ void hex_draw(int forced){
       */
       lcd_hex(
 	      (((unsigned long)adr)<<16) // Address
-	      | ((unsigned int*)adr)[0] //data
+	      | ((unsigned int*) MEMPTR(adr))[0] //data
 	      );
     }
   }
@@ -322,10 +322,11 @@ int jukebox_keypress(char ch) {
 		pinInput();
 	} else if (!pinFlag && (lastch = ch) && ch >= '0' && ch <= '9') {
 	        jukebox_configradio();
-		//This handler will be called back as the packet finished transmission.
+		//Begin the burst, which repeats until the key is released.
 		jukebox_packettx();
 	} else if (!pinFlag) {
-		//Shut down the radio when the button is released.
+		//End the burst and shut down the radio when the button is released.
+		packet_txstop();
 		radio_off();
 		lcd_zero(); //Clear the clock and radio indicators.
 		lcd_string("JBOX  TX");
@@ -356,7 +357,8 @@ int jukebox_fallthrough(char ch) {
     jukebox_configradio();
     jukebox_packettx();
   }else{
-    //On a keyup, make sure the radio is off.
+    //On a keyup, end the burst and make sure the radio is off.
+    packet_txstop();
     radio_off();
   }
   
@@ -364,48 +366,48 @@ int jukebox_fallthrough(char ch) {
 }
 
 
-// Button Mapping
+// Button Mapping, queueing a burst that repeats until packet_txstop().
 void jukebox_packettx() {
 	if (lastch <= '9' && lastch >= '0') {
 		switch (lastch - '0') {
 			case 0: // Skip
-				packet_tx(build_jukebox_packet(4, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(4, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string("  Skip  ");
 				break;
 			case 1: // Pause
-				packet_tx(build_jukebox_packet(0, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(0, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string(" Pause  ");
 				break;
 			case 2: // Down Arrow
-				packet_tx(build_jukebox_packet(12, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(12, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string("D Arrow ");
 				break;
 			case 3: // Lock Queue
-				packet_tx(build_jukebox_packet(25, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(25, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string(" Lock Q ");
 				break;
 			case 4: // Left Arrow
-				packet_tx(build_jukebox_packet(8, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(8, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string("L Arrow ");
 				break;
 			case 5: // OK
-				packet_tx(build_jukebox_packet(9, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(9, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string("   OK   ");
 				break;
 			case 6: // Right Arrow
-				packet_tx(build_jukebox_packet(10, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(10, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string("R Arrow ");
 				break;
 			case 7: // Power
-				packet_tx(build_jukebox_packet(1, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(1, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string(" Power  ");
 				break;
 			case 8: // Up Arrow
-				packet_tx(build_jukebox_packet(6, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(6, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string("Up Arrow");
 				break;
 			case 9: // Edit Queue
-				packet_tx(build_jukebox_packet(3, pin), LEN);
+				packet_txrepeat(build_jukebox_packet(3, pin), LEN, PACKET_REPEATFOREVER);
 				lcd_string(" Edit Q ");
 				break;
 		}
@@ -19,7 +19,8 @@
   initially reversed with Universal Radio Hacker, then a single packet
   was prototyped in Python through the Monitor feature.  Once this
   packet was properly compared to the original, a steady stream of
-  packets was created by the ook_packettx() callback.
+  packets was queued to the packet library, which repeats them
+  back-to-back until the button is released.
   
   The 'bits' are 341 µs long for a symbol rate of 2.93207 kilobaud,
   but because the protocol is designed in terms of short and long
@@ -35,10 +36,10 @@
 
   
   There is no preamble; rather, packets begin on a rising edge in the
-  third byte.  The receiver expects many packets in a row, so we start
-  a new transmittion in the callback after each transmission and we
-  raise the main clock frequency to be able to react in time.  For
-  other receivers, you might be able to get away with a single
+  third byte.  The receiver expects many packets in a row, so we ask
+  packet_txrepeat() to refill the FIFO from its interrupt handler
+  without ever leaving TX mode, which keeps the repeats free of gaps.
+  For other receivers, you might be able to get away with a single
   transmission.
   
   Further details and a tutorial for adding your own remote are in the
@@ -107,11 +108,11 @@ void ook_packetrx(uint8_t *packet, int len){
 static char lastch=0;
 
 
-//! Send a packet.
+//! Send a packet, repeating until packet_txstop().
 static void transmit(int index){
   //Packet begins on the third byte.
-  packet_tx((uint8_t*) button_array[index]+2,
-	    LEN);
+  packet_txrepeat((uint8_t*) button_array[index]+2,
+		  LEN, PACKET_REPEATFOREVER);
 }
 //! Set the rate.
 static void setrate(int index){
@@ -120,10 +121,10 @@ static void setrate(int index){
   radio_writereg(MDMCFG3, ((uint8_t*) button_array[index])[1]);
 }
 
-//! Called after a transmission, or on a button press.
+//! Called on a button press to begin the burst.
 void ook_packettx(){
-  /* Schedule next packet if a number is being held.  We already set
-     the bitrate in the keypress handler.
+  /* Queue the burst if a number is being held.  We already set the
+     bitrate in the keypress handler.
   */
   if(lastch<='9' && lastch>='0'){
     transmit(lastch-'0');
@@ -177,9 +178,8 @@ void ook_draw(){
 //! Keypress handler for the ook applet.
 int ook_keypress(char ch){
   /* When a key is first pressed, we call ook_packettx() to kick off a
-     transmission.  That function is also the callback from the packet
-     library, so it will keep running in a loop until the key is
-     released.
+     transmission.  The packet library repeats that frame back-to-back
+     until the key is released and packet_txstop() ends the burst.
    */
   if( (lastch=ch) && ch>='0' && ch<='9' ){
     //Radio settings.
@@ -190,10 +190,11 @@ int ook_keypress(char ch){
     //Set a frequency manually rather than using the codeplug.
     radio_setfreq(433960000);
 
-    //This handler will be called back as the packet finished transmission.
+    //Begin the burst, which lasts until the key is released.
     ook_packettx();
   }else{
-    //Shut down the radio when the button is released.
+    //End the burst and shut down the radio when the button is released.
+    packet_txstop();
     radio_off();
     lcd_zero(); //Clear the clock and radio indicators.
     lcd_string("     OOK");
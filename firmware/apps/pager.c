@@ -2,10 +2,17 @@
   \brief POCSAG Pager Receiver
   
   Quick little comm demo for receiving POCSAG pages, with an optional
-  promiscuous mode.  Communications work great so long as the message
-  fits into a single burst, as we don't yet have support for long
-  packets.  Get an RIC divisible by 8 to be near the beginning of the
-  burst.
+  promiscuous mode.  Each 66-byte packet is a single batch, two bytes
+  of the FCS and sixteen words, which is more than the radio's FIFO
+  holds, so packet.c drains it as it arrives.  The pocsag library
+  carries a message across batches, so long messages are assembled by
+  keeping the receiver on until they end.  Get an RIC divisible by 8
+  to be near the beginning of the burst.
+
+  Completed messages are kept in a small ring by the library, along
+  with the time of day that they arrived.  The + button steps back to
+  older messages, - scrolls the text of the one on the screen, and =
+  shows its timestamp.
   
   Relevant issues:
   #118 POCSAG/DAPNET Support.
@@ -50,7 +57,7 @@ static const uint8_t pocsag_settings[]={
   FSCAL0 , 0x1F,
   
   PKTCTRL0, 0x00,     // Packet automation control, fixed length without CRC.
-  PKTLEN,  64,        // PKTLEN    Packet length.
+  PKTLEN,  66,        // PKTLEN    Packet length, FCS tail and a batch.
   
   SYNC1, 0x83,        //Sync word is 0x7CD215D8, but inverted from differing
   SYNC0, 0x2d,        //2FSK definitions, the first two bytes become 832d.
@@ -85,7 +92,7 @@ static const uint8_t pocsag_settings[]={
 /* Correct addressing for POCSAG.
  */
 static const uint8_t pocsag_settings_packet[]={
-  PKTLEN,  64,        // PKTLEN    Packet length.
+  PKTLEN,  66,        // PKTLEN    Packet length, FCS tail and a batch.
   
   SYNC1, 0x83,        //Sync word is 0x7CD215D8, but inverted from differing
   SYNC0, 0x2d,        //2FSK definitions, the first two bytes become 832d.
@@ -111,7 +118,14 @@ static const uint8_t pocsag_settings_preamble[]={
 };
 
 static uint16_t wakecount=0;
-static char lastpacket[]="IDLE      ";
+//! Age of the message on the screen, zero being the newest.
+static int msgage=0;
+//! Scroll offset into the message on the screen.
+static int msgscroll=0;
+//! Set to show the timestamp instead of the text.
+static int msgshowtime=0;
+//! Count of messages when we last drew, so new ones reset the view.
+static uint16_t msgseen=0;
 
 //! Handle an incoming packet.
 void pager_packetrx(uint8_t *packet, int len){
@@ -161,6 +175,10 @@ void pager_packetrx(uint8_t *packet, int len){
      already been bitflipped (^=0xFFFFFFFF) and loaded as 32-bit *BIG
      ENDIAN* words.  (The MSP430 is little endian.  Sorry.)
 
+     Each word is run through pocsag_correct() first, which repairs
+     up to two bit errors and turns anything worse into IDLE, so a
+     single flipped bit no longer costs us the whole codeword.
+
      /FCS\ /--word0--\ /--word1--\ /--word2--\ ..
      ea 27 ff d8 da c8 3a ee f9 6c 7e 66 3a 50 ..
   */
@@ -177,24 +195,37 @@ void pager_packetrx(uint8_t *packet, int len){
      sequence.  __builtin_bswap32() is a GCC primitive to swap a
      32-bit word, much like htonl() would do.
   */
+  pocsag_settime(((uint32_t) RTCHOUR)*3600L + RTCMIN*60 + RTCSEC);
   pocsag_newbatch();
-  for(i=0;i<16;i++){
-    pocsag_handleword(__builtin_bswap32(words[i])^0xFFFFFFFF);
+  //Error correction is heavy, so we race through it.
+  ucs_request(UCS_4MHZ);
+  /* Only whole words that arrived are decoded, so padding past a
+     short packet can't decode as an address word.
+   */
+  for(i=0;i<16 && 2+4*i+4<=len;i++)
+    pocsag_handleword(pocsag_correct(__builtin_bswap32(words[i])^0xFFFFFFFF));
+  ucs_release(UCS_4MHZ);
 
-    
-    //Display the packet if it newly matches our ID, or if we have no ID.
-    if(pocsag_lastid==DAPNETRIC || DAPNETRIC==0){
-      memcpy(lastpacket, pocsag_buffer, 8);
-      printf("Displaying: '%s'\n", lastpacket);
-    }
-  }
+  /* A short batch means words went missing, so the next batch can't
+     continue the message.  We end it here with what we have.
+   */
+  if(i<16)
+    pocsag_endmessage();
 
   //Zero the packet just so bugs are clear.
   memset(packet,0xFF,len);
   printf("%ld: %s\n\n",
          pocsag_lastid, pocsag_buffer
          );
-  
+
+  /* If a message is still open at the end of the batch, the next
+     batch follows immediately without a new preamble, so we keep
+     listening for it.
+   */
+  if(pocsag_inmessage()){
+    wakecount=4;
+    packet_rxon();
+  }
 }
 
 
@@ -214,6 +245,9 @@ void pager_init(){
     
     radio_setfreq(439988000);
     //packet_rxon();
+
+    //Only our own messages are stored, unless we have no ID.
+    pocsag_filter=DAPNETRIC;
   }else{
     app_next();
   }
@@ -229,6 +263,39 @@ int pager_exit(){
   return 0;
 }
 
+//! Draws the selected message, or its timestamp.
+static void pager_drawmessage(){
+  const struct pocsag_message *msg;
+  uint32_t t;
+
+  //New messages jump back to the front.
+  if(msgseen!=pocsag_messagecount){
+    msgseen=pocsag_messagecount;
+    msgage=0;
+    msgscroll=0;
+  }
+  
+  msg=pocsag_getmessage(msgage);
+  if(!msg){
+    lcd_string("IDLE    ");
+    return;
+  }
+
+  if(msgshowtime){
+    t=msg->time;
+    lcd_digit(7,(t/36000)%10);
+    lcd_digit(6,(t/3600)%10);
+    setcolon(1);
+    t%=3600;
+    lcd_digit(4,t/600);
+    lcd_digit(3,(t/60)%10);
+    lcd_digit(1,(t%60)/10);
+    lcd_digit(0,t%10);
+  }else{
+    lcd_string(msg->text+msgscroll);
+  }
+}
+
 //! Draw the Pager screen.
 void pager_draw(){
 
@@ -280,9 +347,9 @@ void pager_draw(){
   state=radio_getstate();
   
   if(state==1 || state==13){
-    /* Draw the last incoming packet on the screen. */
+    /* Draw the selected message on the screen. */
     lcd_zero();
-    lcd_string(lastpacket);
+    pager_drawmessage();
   }else{
     printf("Unexpected state %d\n", state);
     lcd_number(state);
@@ -304,6 +371,8 @@ void pager_draw(){
     if(wakecount){
       wakecount--;
     }else{
+      //Whatever we have of an unfinished message is all we'll get.
+      pocsag_endmessage();
       packet_rxoff();
       //radio_off();
     }
@@ -317,12 +386,32 @@ void pager_draw(){
 
 //! Keypress handler for the pager applet.
 int pager_keypress(char ch){
-  /* For now, the pager doesn't bother responding to keypresses.  In
-     the future, it might be nice for this to show (1) the timestamp
-     of the last received packet and (2) a promiscuous mode showing
-     all recent packets.
+  /* These only change what we show, never the radio, so that
+     browsing old messages doesn't cost us any battery.
    */
-
+  const struct pocsag_message *msg;
+  
+  switch(ch){
+  case '+': //Step back to an older message, wrapping to the newest.
+    msgage++;
+    if(!pocsag_getmessage(msgage))
+      msgage=0;
+    msgscroll=0;
+    msgshowtime=0;
+    return 1;
+  case '-': //Scroll the text, wrapping to the beginning.
+    msg=pocsag_getmessage(msgage);
+    msgshowtime=0;
+    if(msg && strlen(msg->text)>msgscroll+8)
+      msgscroll+=4;
+    else
+      msgscroll=0;
+    return 1;
+  case '=': //Toggle the timestamp.
+    msgshowtime=!msgshowtime;
+    return 1;
+  }
+  
   return 0;
 }
 
@@ -15,28 +15,28 @@
 
 
 #include "api.h"
-#include "rpn.h"
+#include "applist.h"
 
-#define STACKSIZE 10
+#define STACKSIZE RPN_STACKSIZE
 
-static long stack[STACKSIZE];
-static long buffer=0;
-static int bufferdirty=0;
-static unsigned int stacki=0;
+/* Our state lives in the applet overlay, so it is only valid
+   between rpn_init() and a successful rpn_exit().
+ */
+static struct rpn_state *const s=&app_overlay.rpn;
 
 
 //! Peeks at the top item of the stack.
 static long rpn_peek(){
-  return stack[stacki%STACKSIZE];
+  return s->stack[s->stacki%STACKSIZE];
 }
 //! Pushes a new value onto the stack.
 static void rpn_push(long val){
-  stack[(++stacki)%STACKSIZE]=val;
+  s->stack[(++s->stacki)%STACKSIZE]=val;
   rpn_draw(1);
 }
 //! Pops the top item from the stack.
 static long rpn_pop(){
-  long i=stack[(stacki--)%STACKSIZE];
+  long i=s->stack[(s->stacki--)%STACKSIZE];
   rpn_draw(1);
   return i;
 }
@@ -48,12 +48,12 @@ static void rpn_drawstack(){
   long todraw=0;
   
   //AM indicates the current input.
-  setam(bufferdirty?1:0);
+  setam(s->bufferdirty?1:0);
   
-  if(!bufferdirty)
-    todraw=stack[stacki%STACKSIZE];
+  if(!s->bufferdirty)
+    todraw=s->stack[s->stacki%STACKSIZE];
   else
-    todraw=buffer;
+    todraw=s->buffer;
 
   lcd_number(todraw);
 }
@@ -61,13 +61,13 @@ static void rpn_drawstack(){
 //! Pushes the buffer to the stack if it has been modified.
 static void rpn_pushbuffer(){
   //Do nothing unless the buffer is in use.
-  if(!bufferdirty) return;
+  if(!s->bufferdirty) return;
 
   //If the buffer is dirty, we'll zero it, mark it clean, and push it
   //to the call stack.
-  bufferdirty=0;
-  rpn_push(buffer);
-  buffer=0;
+  s->bufferdirty=0;
+  rpn_push(s->buffer);
+  s->buffer=0;
   
 }
 //! Presses one digit into the buffer.
@@ -78,8 +78,8 @@ static void rpn_updatebuffer(int i){
      in assembly for now.
    */
   
-  bufferdirty=1;
-  buffer=buffer*10+i;
+  s->bufferdirty=1;
+  s->buffer=s->buffer*10+i;
 }
 
 
@@ -87,9 +87,8 @@ static void rpn_updatebuffer(int i){
 void rpn_init(){
   int i;
 
-  
-  
   //Fresh stack when we enter the calculator.
+  app_claim();
   for(i=0;i<STACKSIZE;i++)
     rpn_push(0);
 
@@ -99,12 +98,13 @@ void rpn_init(){
 
 //! RPN handler for sidebutton.
 int rpn_exit(){
-  if(bufferdirty){
+  if(s->bufferdirty){
     // Push the incoming number if it's not yet committed.
     rpn_pushbuffer();
     return 1;
   } else if(rpn_peek()==0){
     // Exit if zero is the latest number.
+    app_release();
     return 0;
   }
   
@@ -130,10 +130,10 @@ int rpn_keypress(char ch){
     return 0;
 
 
-  //Operators
+  //Operators.
   switch(ch){
   case '=':
-    if(bufferdirty)          //Push the value if it's waiting.
+    if(s->bufferdirty)       //Push the value if it's waiting.
       rpn_pushbuffer();
     else                     //Otherwise duplicate bottom stack item.
       rpn_push(rpn_peek()); 
@@ -154,13 +154,24 @@ int rpn_keypress(char ch){
     break;
   case '*':
     rpn_pushbuffer();
-    rpn_push(rpn_pop()*rpn_pop());
+    /* The MSP430 multiplies and divides longs in software, so we race
+       through them at a fast MCLK.
+     */
+    j=rpn_pop();
+    i=rpn_pop();
+    ucs_request(UCS_4MHZ);
+    i*=j;
+    ucs_release(UCS_4MHZ);
+    rpn_push(i);
     break;
   case '/':
     rpn_pushbuffer();
     j=rpn_pop();
     i=rpn_pop();
-    rpn_push(i/j);
+    ucs_request(UCS_4MHZ);
+    i/=j;
+    ucs_release(UCS_4MHZ);
+    rpn_push(i);
     break;
   }
 
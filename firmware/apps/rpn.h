@@ -2,6 +2,17 @@
   \brief RPN Calculator application.
 */
 
+//! Depth of the stack.
+#define RPN_STACKSIZE 10
+
+//! Calculator state, kept in the applet overlay.
+struct rpn_state {
+  long stack[RPN_STACKSIZE];
+  long buffer;
+  int bufferdirty;
+  unsigned int stacki;
+};
+
 //! Initialize the RPN calculator.
 void rpn_init();
 //! Draw the RPN calculator.
@@ -26,7 +26,7 @@ void settime_init(){
 static void reallyexit(){
   //Return to the clock applet.
   app_reset();
-  draw_time(1);
+  draw_time(1, 0);
 }
 
 //! Move to the next digit, or finally exit the applet.
@@ -39,7 +39,7 @@ int settime_exit(){
     //Not setting the time, so we move back to our own app by undoing
     //the app_set() call in clock.c.
     app_reset();
-    draw_time(1);
+    draw_time(1, 0);
     return 1;
   }
 }
@@ -65,7 +65,7 @@ void settime_draw(int forced){
   //First we draw the entire thing, then we blink the second being
   //set.
   if(settingclock<5)
-    draw_time(1);
+    draw_time(1, 0);
   else
     draw_date();
 
@@ -11,6 +11,13 @@
   buttons are ignored.  The drawing function will monitor that
   interrupts and GPIO pins remain in a kosher state and display an
   error if they have accidentally changed.
+
+  As nothing can be done in this mode anyway, it is the deepest sleep
+  that we have.  After the first draw, the WDT's frames are stopped,
+  and the watch wakes only for the RTC's minute event, which draws the
+  hours and minutes, or for the falling edge of the SET button on
+  P1.6, which wakes the frames back up.  That's one wakeup a minute,
+  rather than four a second.
   
 */
 
@@ -89,8 +96,19 @@ static int test_shabbat(){
   return 0;
 }
 
+//! Stops the frames until the next minute, or until SET is pressed.
+static void sleep_shabbat(){
+  //Mode is an output now, so only SET's edge may wake us.
+  sidebutton_arm(BIT6);
+  app_frames(0);
+}
+
 //! Exit to normal mode.
 static void exit_shabbat(){
+  //No more edges from SET, and the frames return.
+  sidebutton_disarm();
+  app_frames(1);
+
   //Return keypad to normal.
   key_init();
   //Return sidebuttons to normal.
@@ -123,7 +141,7 @@ int shabbat_exit(){
 //! Draw the Shabbat screen.
 void shabbat_draw(){
   //Use the SET button to exit Shabbat mode.
-  if(sidebutton_set()){
+  if(sidebutton_set() || (sidebutton_woken()&BIT6)){
     //Return GPIO to normal, which should show the PANIC message.
     exit_shabbat();
   }
@@ -136,9 +154,13 @@ void shabbat_draw(){
     return;
   }
     
+  //Everything is kosher, so we sleep until the next minute.
+  if(app_frameson())
+    sleep_shabbat();
+
   /* We draw the time with the same redraw behavior as the standard
-     clock applet. */
-  draw_time(redraw);
+     clock applet, but without the seconds while asleep. */
+  draw_time(redraw, 1);
   if(redraw)
     redraw--;
 
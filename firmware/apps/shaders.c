@@ -140,13 +140,13 @@ static void transmit(int command){
   encrypt(packet+SHADERS_PACKET_LENGTH-SHADERS_RAW_PAYLOAD_LENGTH, SHADERS_RAW_PAYLOAD_LENGTH);
   manchester_encode(packet+SHADERS_PACKET_LENGTH-2*SHADERS_RAW_PAYLOAD_LENGTH, 2*SHADERS_RAW_PAYLOAD_LENGTH);
   memcpy(packet, prefix, SHADERS_PREFIX_LENGTH);
-  packet_tx(packet, SHADERS_PACKET_LENGTH);
+  //The packet library copies the frame and repeats it until packet_txstop().
+  packet_txrepeat(packet, SHADERS_PACKET_LENGTH, PACKET_REPEATFOREVER);
 }
 
-//! Called after a transmission, or on a button press.
+//! Called on a button press to begin the burst.
 void shaders_packettx(){
-  /* Schedule next packet if a number is being held.  We should send the same packet?
-  */
+  //Queue the burst if a command is being held.
   switch (lastch)
   {
   case '/':
@@ -190,9 +190,7 @@ void shaders_draw(){
   switch(state){
   case 0:
   case 1:
-    break;
-  case 19: //RX IDLE between transmit packets.
-    lcd_string("TRANSMIT");
+  case 19: //TX, which lasts for the whole burst.
     break;
   case 22: //TX_OVERFLOW
     printf("TX Overflow.\n");
@@ -207,9 +205,8 @@ void shaders_draw(){
 //! Keypress handler for the shaders applet.
 int shaders_keypress(char ch){
   /* When a key is first pressed, we call shaders_packettx() to kick off a
-     transmission.  That function is also the callback from the packet
-     library, so it will keep running in a loop until the key is
-     released.
+     transmission.  The packet library repeats that frame back-to-back
+     until the key is released and packet_txstop() ends the burst.
    */ 
   if(ch<='9' && ch>='1'){
     selected_id = ch-'0';
@@ -225,15 +222,17 @@ int shaders_keypress(char ch){
     //Set a frequency manually rather than using the codeplug.
     radio_setfreq(433420000);
 
-    //This handler will be called back as the packet finished transmission.
+    //Begin the burst, which lasts until the key is released.
     shaders_packettx();
+    lcd_string("TRANSMIT");
   }else{
     if (lastch=='/' || lastch=='*' || lastch=='-' || lastch=='='){
       //Increase rolling code when the button is release
       rolling_codes[selected_id-1] = rolling_codes[selected_id-1]+1;
     }
     lastch = ch;
-    //Shut down the radio when the button is released.
+    //End the burst and shut down the radio when the button is released.
+    packet_txstop();
     radio_off();
     lcd_zero(); //Clear the clock and radio indicators.
     lcd_string(" SHADERS");
@@ -132,7 +132,7 @@ void stopwatch_draw(int forced){
   
   //When / is held, we always show the time and exit.
   if(showtime){
-    draw_time(1);
+    draw_time(1, 0);
     return;
   }
 
@@ -11,6 +11,8 @@
   
 */
 
+#include <stdio.h>
+
 #include "api.h"
 #include "applist.h"
 
@@ -66,6 +68,11 @@ int submenu_exit(){
   // unset the signs on submenu exit
   setplus(0); 
   setminus(0);
+  //Radio applets are refused on a low battery, so Mode moves on past us.
+  if(battery_low && subapps[subindex].radio){
+    printf("No radio on a low battery.\n");
+    return 0;
+  }
   //Set the new app.
   app_set(&subapps[subindex]);
   //Return 1 so app_next() won't move us to the next major app.
@@ -78,6 +85,8 @@ int submenu_fallthrough(char ch){
      fall through, but only the third row (1,2,3,-) is expected to
      remain unused.
    */
+  if(battery_low && subapps[subindex].radio)
+    return 1;
   if(subapps[subindex].fallthrough)
     return subapps[subindex].fallthrough(ch);
 
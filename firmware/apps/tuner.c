@@ -15,6 +15,10 @@
 #include<msp430.h>
 #include<string.h>
 #include "api.h"
+#include "applist.h"
+
+//! Tuner state, in the applet overlay between tuner_init() and tuner_exit().
+static struct tuner_state *const s=&app_overlay.tuner;
 
 //Draws the codeplug name.
 static void draw(){
@@ -31,6 +35,8 @@ void tuner_init(){
      the RSSI.
    */
   if(has_radio){
+    app_claim();
+    s->rssi=0x5;
     radio_on();
     radio_writesettings(0);
     radio_writepower(0x25);
@@ -46,23 +52,17 @@ int tuner_exit(){
   /* Always turn the radio off at exit.
    */
   radio_off();
+  app_release();
 
   //Allow the exit.
   return 0;
 }
 
-//! Last character pressed in the tuner.
-static int vfosetmode=0;
-static int rssi=0x5;
-
-
-int vfosetmode_bufferi;
-char vfosetmode_buffer[9];
 
 static void vfosetmode_apply(){
-  long f=atol(vfosetmode_buffer);
+  long f=atol(s->vfosetmode_buffer);
 
-  vfosetmode=0;
+  s->vfosetmode=0;
   printf("Setting frequency to %ld\n",f);
   codeplug_setvfofreq((float) f);
 }
@@ -70,10 +70,10 @@ static void vfosetmode_apply(){
 static void vfosetmode_keypress(char ch){
   //Numbers populate a buffer character.
   if(ch>='0' && ch<='9')
-    vfosetmode_buffer[vfosetmode_bufferi++]=ch;
+    s->vfosetmode_buffer[s->vfosetmode_bufferi++]=ch;
 
   //Exit when we have all characters or = is pressed again.
-  if(ch=='=' || vfosetmode_bufferi==8){
+  if(ch=='=' || s->vfosetmode_bufferi==8){
     vfosetmode_apply();
   }
 }
@@ -83,7 +83,7 @@ static void vfosetmode_draw(){
      frequency.  Activate the mode by pressing the = button.
    */
   clearperiods();
-  lcd_string(vfosetmode_buffer);
+  lcd_string(s->vfosetmode_buffer);
   setperiod(5,1);
   setperiod(2,1);
 }
@@ -91,7 +91,7 @@ static void vfosetmode_draw(){
 
 //! Tuner keypress callback.
 int tuner_keypress(char ch){
-  if(vfosetmode){
+  if(s->vfosetmode){
     vfosetmode_keypress(ch);
     return 0;
   }
@@ -112,13 +112,13 @@ int tuner_keypress(char ch){
     lcd_number(codeplug_getfreq()/10);
     break;
   case '=':  //Set a VFO frequency.
-    vfosetmode=1;
+    s->vfosetmode=1;
     //Clear all eight digits, plus null terminator.
-    memset(vfosetmode_buffer,'0',9);
-    vfosetmode_bufferi=0;
+    memset(s->vfosetmode_buffer,'0',9);
+    s->vfosetmode_bufferi=0;
     break;
   case '7':  //Show snapshot of scalar RSSI.
-    lcd_number(rssi);
+    lcd_number(s->rssi);
     lcd_string("RSSI");
     break;
   }
@@ -132,7 +132,7 @@ void tuner_draw(){
   static int i=0;
   
   //No sense using the radio when we don't yet know the frequency.
-  if(vfosetmode){
+  if(s->vfosetmode){
     vfosetmode_draw();
     return;
   }
@@ -140,11 +140,11 @@ void tuner_draw(){
   /* Every other frame, we grab the signal strength.  Highest
      stays. */
   if(!(i&1))
-    rssi=radio_getrssi();
+    s->rssi=radio_getrssi();
   
   //Draw the new strength.
   clearperiods();
-  switch(rssi&0xF0){
+  switch(s->rssi&0xF0){
   case 0xF0:
   case 0xE0:
     setperiod(0,1);
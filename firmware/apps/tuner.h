@@ -2,6 +2,14 @@
   \brief Tuning application and RSSI tool.
 */
 
+//! Tuner state, kept in the applet overlay.
+struct tuner_state {
+  int vfosetmode;
+  int rssi;
+  int vfosetmode_bufferi;
+  char vfosetmode_buffer[9];
+};
+
 //! Enter the radio tool.
 void tuner_init();
 //! Exit the radio tool.
@@ -0,0 +1,90 @@
+/*! \file battery.c
+  \brief Low battery monitor.
+
+  A CR2016 holds its voltage for most of its life, then sags quickly
+  at the end, and the radio's current draw can push a tired cell into
+  a brownout.  So every few minutes the RTC's minute event samples
+  Vcc, with the reference and the ADC powered only for the one
+  conversion.
+
+  Below BATTERYLOW, the watch degrades itself to last longer: radio
+  applets are refused, the buzzer is silenced, the clock stops drawing
+  seconds and dozes between minutes, and the LCD charge pump runs at
+  its weakest contrast.  It
+  recovers above BATTERYOK, which is a bit higher so that a cell near
+  the threshold won't flip back and forth.  Both are in hundredths of
+  a volt, and can be set in config.h.
+*/
+
+#include <msp430.h>
+#include <stdio.h>
+#include "api.h"
+#include "applist.h"
+
+//! Non-zero while the battery is low and the watch is saving power.
+int battery_low=0;
+
+//! Last sampled battery voltage, in hundredths of a volt.
+unsigned int battery_vcc=0;
+
+//! Enters the degraded mode.
+static void battery_degrade(){
+  printf("Battery low at %d, saving power.\n", battery_vcc);
+  battery_low=1;
+
+  //A buzzer left running would be the end of us.
+  buzz(0);
+  lcd_contrast(0);
+
+  //Radio applets must leave, and their exit() turns the radio off.
+  if(applet->radio)
+    app_forcehome();
+}
+
+//! Leaves the degraded mode.
+static void battery_restore(){
+  printf("Battery recovered at %d.\n", battery_vcc);
+  battery_low=0;
+  lcd_contrast(1);
+}
+
+//! Waits the 75us that the reference needs to settle after ref_on().
+static void battery_settle(){
+  /* __delay_cycles() needs a constant, so we pick one for MCLK's
+     operating point.  A sample taken too early reads low, and would
+     send us into the degraded mode for nothing.
+   */
+  switch(ucs_speed()){
+  case UCS_ACLK:
+    __delay_cycles(3);
+    break;
+  case UCS_1MHZ:
+    __delay_cycles(79);
+    break;
+  case UCS_2MHZ:
+    __delay_cycles(158);
+    break;
+  default:
+    __delay_cycles(315);
+    break;
+  }
+}
+
+//! Called from the RTC's minute event to sample the battery.
+void battery_minute(){
+  static unsigned int minutes=0;
+
+  //The first sample is taken on the first minute after boot.
+  if(minutes++%BATTERYMINUTES)
+    return;
+
+  ref_on();
+  battery_settle();
+  battery_vcc=adc_getvcc();
+  ref_off();
+
+  if(!battery_low && battery_vcc<BATTERYLOW)
+    battery_degrade();
+  else if(battery_low && battery_vcc>=BATTERYOK)
+    battery_restore();
+}
@@ -0,0 +1,12 @@
+/*! \file battery.h
+  \brief Low battery monitor.
+*/
+
+//! Non-zero while the battery is low and the watch is saving power.
+extern int battery_low;
+
+//! Last sampled battery voltage, in hundredths of a volt.
+extern unsigned int battery_vcc;
+
+//! Called from the RTC's minute event to sample the battery.
+void battery_minute();
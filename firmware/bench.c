@@ -0,0 +1,166 @@
+/*! \file bench.c
+  \brief Cycle count benchmarks, run in mspdebug's simulator.
+
+  This replaces main.c in bench.elf, which 'make bench' builds for the
+  plain MSP430 core and runs in the simulator of mspdebug by
+  bin/bench.py.  The harness sets a breakpoint on bench_mark() and
+  reads the simulator's MCLK count at each stop, so the cycles of a
+  benchmark are those between its two marks.
+
+  Every benchmark has a setup function, which runs before the first
+  mark and isn't counted, and a function to be measured.  The first
+  benchmark is empty, to measure the cost of the marks themselves,
+  which the harness subtracts from the others.
+
+  Keep this table in the same order as benchbudgets.txt.  The harness
+  checks that the index passed to bench_mark() matches, so a mismatch
+  fails loudly rather than blaming the wrong function.
+*/
+
+#include <msp430.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "api.h"
+#include "optim.h"
+#include "apps/clock.h"
+#include "libs/hebrew.h"
+
+//! Stands in for the self-test of main.c, which clock.c calls.
+int post(){
+  return 0;
+}
+
+//! A benchmark.
+struct bench {
+  //! Name, as in benchbudgets.txt.
+  const char *name;
+  //! Runs before the first mark, uncounted.  May be null.
+  void (*setup)();
+  //! The code being measured.
+  void (*run)();
+};
+
+//! Last mark, for the debugger's convenience.
+volatile int bench_index;
+
+/* The harness breaks here.  It must never be inlined, or there'd be
+   nothing to break on, and the argument lands in R12 where the
+   harness can check it.
+ */
+void __attribute__ ((noinline)) bench_mark(int index){
+  bench_index=index;
+}
+
+static void nothing(){
+}
+
+static void draw_time_full(){
+  draw_time(1, 0);
+}
+static void draw_time_idle(){
+  draw_time(0, 0);
+}
+//! Nothing has changed, as in three frames of four.
+static void setup_idle(){
+  draw_time(1, 0);
+}
+//! The second has changed, but not the tens digit.
+static void setup_second(){
+  RTCSEC=11;
+  draw_time(1, 0);
+  RTCSEC=12;
+}
+//! The minute has changed, so the hour is drawn with it.
+static void setup_minute(){
+  RTCMIN=11;
+  RTCSEC=59;
+  draw_time(1, 0);
+  RTCMIN=12;
+  RTCSEC=0;
+}
+
+static void lcd_string_run(){
+  lcd_string("goodwatc");
+}
+static void setup_number(){
+  lcd_number(1);
+}
+static void lcd_number_run(){
+  lcd_number(-1234567);
+}
+static void l2bcd_run(){
+  l2bcd(12345678);
+}
+
+static void setup_pocsag(){
+  pocsag_newbatch();
+}
+//! Address word of the alpha message in libs/pocsag.c's self test.
+static void pocsag_address_run(){
+  pocsag_handleword(0x08fa5e2b);
+}
+//! First data word of that same message.
+static void pocsag_data_run(){
+  pocsag_handleword(0xe9d25fc7);
+}
+
+static uint32_t udate;
+static struct hebrew_date hdate;
+static void hebrew_universal_run(){
+  udate=hebrew_get_universal(2018, 9, 10);
+}
+static void hebrew_calendar_run(){
+  hebrew_calendar_from_universal(udate, &hdate);
+}
+
+//! mov #0x1234, r15
+static void asm_dis_run(){
+  asm_dis(0x4400, 0x403f, 0x1234, 0);
+}
+
+//! Benchmarks, in the order of benchbudgets.txt.
+static const struct bench benches[]={
+  {"empty", 0, nothing},
+  {"draw_time_idle", setup_idle, draw_time_idle},
+  {"draw_time_second", setup_second, draw_time_idle},
+  {"draw_time_minute", setup_minute, draw_time_idle},
+  {"draw_time_full", 0, draw_time_full},
+  {"lcd_string", 0, lcd_string_run},
+  {"lcd_number", setup_number, lcd_number_run},
+  {"lcd_number_cached", 0, lcd_number_run},
+  {"l2bcd", 0, l2bcd_run},
+  {"pocsag_address", setup_pocsag, pocsag_address_run},
+  {"pocsag_data", 0, pocsag_data_run},
+  {"hebrew_get_universal", 0, hebrew_universal_run},
+  {"hebrew_from_universal", 0, hebrew_calendar_run},
+  {"asm_dis", 0, asm_dis_run},
+  {0, 0, 0}
+};
+
+//! Runs each benchmark between a pair of marks.
+int main(void) {
+  const struct bench *b;
+  int i=0;
+
+  WDTCTL = WDTPW + WDTHOLD; // Stop WDT
+  init_printf(NULL, dmesg_putc);
+  dmesg_init();
+  /* The LCD isn't initialized.  In the simulator, its registers are
+     plain RAM, so lcd_zero() would spin out all of its LCDCLRMTRIES
+     waiting on LCDCLRM, and the drawing benchmarks only need the
+     memory that they write.
+   */
+
+  for(b=benches; b->name; b++){
+    if(b->setup)
+      b->setup();
+    bench_mark(i++);
+    b->run();
+    bench_mark(i++);
+  }
+
+  //The harness stops at the last mark, so we never get here.
+  printf("Benchmarks done.\n");
+  while(1);
+}
@@ -10,10 +10,12 @@
 
 #include<stdio.h>
 
+#include "battery.h"
+
 //! Make a quick buzz.
 void buzz(unsigned int count){
-  //Start the timer.
-  if(count){
+  //Start the timer, unless the battery is too low to afford it.
+  if(count && !battery_low){
     //Output select mode for P2.7.
     P2DIR|=0x80;
     P2SEL|=0x80;
@@ -36,6 +38,9 @@ void buzz(unsigned int count){
 
 //! blocking tone generation function with duration
 void tone(unsigned int freq, unsigned int duration) {
+  //A low battery can't afford the piezo, so we skip the wait too.
+  if(battery_low)
+    return;
   // output select mode for P2.7.
   P2DIR|=0x80;
   P2SEL|=0x80;
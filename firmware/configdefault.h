@@ -23,6 +23,32 @@
 #define COREVOLTAGE 0
 #endif
 
+/* The battery is sampled every BATTERYMINUTES minutes.  Below
+   BATTERYLOW the watch saves power by refusing radio applets, the
+   buzzer and the seconds, until it rises to BATTERYOK.  Voltages are
+   in hundredths of a volt.
+ */
+#ifndef BATTERYMINUTES
+#define BATTERYMINUTES 10
+#endif
+#ifndef BATTERYLOW
+#define BATTERYLOW 260
+#endif
+#ifndef BATTERYOK
+#define BATTERYOK 270
+#endif
+
+/* With CLOCKMINUTES, the clock blanks its seconds and sleeps from
+   minute to minute once no key has been pressed for CLOCKAWAKE
+   seconds.  A low battery does the same.
+ */
+#ifndef CLOCKMINUTES
+#define CLOCKMINUTES 0
+#endif
+#ifndef CLOCKAWAKE
+#define CLOCKAWAKE 10
+#endif
+
 //Override this in config.h if you're testing an applet.
 #ifndef DEFAULTAPP
 #define DEFAULTAPP 0
@@ -12,6 +12,12 @@
 // The core voltage should be 0 for a coin cell, 2 or 3 for quality power.
 //#define COREVOLTAGE 3
 
+// Uncomment this to trade the seconds for one wakeup a minute.
+//#define CLOCKMINUTES 1
+
+// Below this many hundredths of a volt, the watch saves power.
+//#define BATTERYLOW 260
+
 // Uncomment this to emulate the SET button by holding + and - at once.
 //#define EMULATESET
 
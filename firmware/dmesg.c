@@ -2,12 +2,13 @@
   \brief Kernel debug message buffer.
 */
 
+#include<msp430.h>
 #include<stdio.h>
 #include<string.h>
 
-#include "dmesg.h"
+#include "api.h"
 
-/* These three buffers are declared to be in the .noinit section so
+/* These variables are declared to be in the .noinit section so
    that a reboot will not wipe the buffer.  Because the memory will be
    corrupted when power is lost, we manually wipe the buffer at
    startup if the magic is corrupted or if the index is unreasonable.
@@ -17,16 +18,23 @@
 uint32_t dmesg_magic __attribute__ ((section (".noinit")));
 //! Index within that buffer.
 uint16_t dmesg_index __attribute__ ((section (".noinit")));
+//! Count of characters written since the buffer was cleared.
+uint32_t dmesg_seq __attribute__ ((section (".noinit")));
+//! Changes whenever the buffer is cleared, so the host can notice.
+uint16_t dmesg_epoch __attribute__ ((section (".noinit")));
 
 //! DMESG buffer itself.
-char *dmesg_buffer=(char*)0x2400;
+char *dmesg_buffer=(char*) MEMPTR(0x2400);
 
 //! Writes a character to the dmesg buffer.
 int putchar(int c){
-  dmesg_index++;
-  while(dmesg_index>DMESGLEN)
-    dmesg_index=dmesg_index-DMESGLEN;
-  return dmesg_buffer[dmesg_index]=(char) c;
+  /* The index is always the next position to be written, and it is
+     always the low bits of the sequence count.
+   */
+  dmesg_buffer[dmesg_index]=(char) c;
+  dmesg_index=(dmesg_index+1)&(DMESGLEN-1);
+  dmesg_seq++;
+  return c;
 }
 
 //! Writes a character to the dmesg buffer.
@@ -35,16 +43,107 @@ void dmesg_putc(void* p, char c){
 }
 
 
+#ifdef DMESG_TOKENS
+#include <stdarg.h>
+
+//! Writes a token record to the dmesg buffer.
+void dmesg_token(uint16_t token, uint16_t types, ...){
+  /* This is all that's left of printf() in a tokenized build: the
+     marker, the token and the raw arguments, little endian.  Strings
+     are copied with their terminator, as the host can't read them
+     later.
+   */
+  va_list ap;
+  uint16_t word;
+  uint32_t dword;
+  const char *str;
+
+  putchar(DMESG_TOKENMARK);
+  putchar(token&0xFF);
+  putchar(token>>8);
+
+  va_start(ap, types);
+  for(; types; types>>=2){
+    switch(types&3){
+    case DMESG_ARG16:
+      word=va_arg(ap, int);
+      putchar(word&0xFF);
+      putchar(word>>8);
+      break;
+    case DMESG_ARG32:
+      dword=va_arg(ap, long);
+      putchar(dword&0xFF);
+      putchar((dword>>8)&0xFF);
+      putchar((dword>>16)&0xFF);
+      putchar(dword>>24);
+      break;
+    case DMESG_ARGSTR:
+      str=va_arg(ap, const char*);
+      do
+        putchar(*str);
+      while(*str++);
+      break;
+    }
+  }
+  va_end(ap);
+}
+#endif
+
+#ifdef DMESG_MARKS
+//! Writes a timestamped event marker, with an optional label.
+void dmesg_mark(uint8_t event, const char *label){
+  /* In calendar mode, RTCPS0 counts ACLK and the low seven bits of
+     RTCPS1 count it over 256, so together they give the 32kHz tick
+     within the second.  The minute lets the host find where the ring
+     wraps.
+   */
+  uint8_t ps0=RTCPS0, ps1=RTCPS1;
+
+  putchar(DMESG_MARKBYTE);
+  putchar(event);
+  putchar(RTCMIN);
+  putchar(RTCSEC);
+  putchar(ps0);
+  putchar(ps1);
+  if(label)
+    while(*label)
+      putchar(*label++);
+  putchar(0);
+}
+#endif
+
+//! Copies out characters from *seq onward, returning the count.
+uint16_t dmesg_read(uint16_t epoch, uint32_t *seq, char *buffer, uint16_t len){
+  uint32_t oldest=dmesg_seq>DMESGLEN ? dmesg_seq-DMESGLEN : 0;
+  uint16_t i;
+
+  /* If the host is behind by more than the buffer, or if the buffer
+     was cleared since it last looked, it gets everything we have.
+   */
+  if(epoch!=dmesg_epoch || *seq<oldest || *seq>dmesg_seq)
+    *seq=oldest;
+
+  if(len>dmesg_seq-*seq)
+    len=dmesg_seq-*seq;
+  for(i=0; i<len; i++)
+    buffer[i]=dmesg_buffer[(*seq+i)&(DMESGLEN-1)];
+  return len;
+}
+
+
 //! Clears the dmesg buffer.
 void dmesg_clear(){
   memset(dmesg_buffer, 0, DMESGLEN);
   dmesg_index=0;
+  dmesg_seq=0;
+  dmesg_epoch++;
   dmesg_magic=0xdeadbeef;
 }
 
 //! I ain't never initialized a buffer that didn't need initializin'.
 void dmesg_init(){
-  if(dmesg_magic!=0xdeadbeef){
+  if(dmesg_magic!=0xdeadbeef
+     || dmesg_index!=(dmesg_seq&(DMESGLEN-1))){
     dmesg_clear();
     printf("Zeroed buffer for bad magic.");
   }
@@ -4,19 +4,28 @@
 
 #include <stdint.h>
 #include "printf.h"
+#include "dmesgtok.h"
 
+//! Length of the buffer, which must be a power of two.
 #define DMESGLEN 2048
 
 //! Ought to be 0xdeadbeef except after power loss.
 extern uint32_t dmesg_magic;
 //! Index within that buffer.
 extern uint16_t dmesg_index;
+//! Count of characters written since the buffer was cleared.
+extern uint32_t dmesg_seq;
+//! Changes whenever the buffer is cleared, so the host can notice.
+extern uint16_t dmesg_epoch;
 //! Buffer itself.
 extern char *dmesg_buffer;
 
 //! Clears the dmesg buffer.
 void dmesg_clear();
 
+//! Copies out characters from *seq onward, returning the count.
+uint16_t dmesg_read(uint16_t epoch, uint32_t *seq, char *buffer, uint16_t len);
+
 //! I ain't never initialized a buffer that didn't need initializin'.
 void dmesg_init();
 
@@ -24,3 +33,32 @@ void dmesg_init();
 //! Putc implementation for the printf library.
 void dmesg_putc(void* p, char c);
 
+
+/* When built with DMESG_MARKS, the firmware also writes timestamped
+   event markers into the buffer, so that bin/energymarks.py can line
+   them up with an EnergyTrace capture and charge the current to the
+   code that drew it.  Each record is DMESG_MARKBYTE, the event, the
+   RTC's minute and second, RTCPS0 and RTCPS1, then a label that ends
+   with a zero byte.  Uppercase events begin a span and the matching
+   lowercase events end it.
+ */
+
+//! Begins a marker record.  Neither text nor tokens use it.
+#define DMESG_MARKBYTE 0xFE
+
+#define DMESG_MARK_APP      'A'  //Applet switch, labeled with its name.
+#define DMESG_MARK_DRAW     'D'  //Applet's draw() begins.
+#define DMESG_MARK_DRAWN    'd'  //Applet's draw() ends.
+#define DMESG_MARK_RADIOON  'R'  //Radio powered up.
+#define DMESG_MARK_RADIOOFF 'r'  //Radio powered down.
+#define DMESG_MARK_RXON     'X'  //Receive window opens.
+#define DMESG_MARK_RXOFF    'x'  //Receive window closes.
+
+#ifdef DMESG_MARKS
+//! Writes a timestamped event marker, with an optional label.
+void dmesg_mark(uint8_t event, const char *label);
+#define DMESG_MARK(event, label) dmesg_mark(event, label)
+#else
+#define DMESG_MARK(event, label)
+#endif
+
@@ -0,0 +1,81 @@
+/*! \file dmesgtok.h
+  \brief Tokenized printf() for the dmesg buffer.
+
+  When built with DMESG_TOKENS, printf() no longer formats anything on
+  the watch.  Each format string is moved into the .dmesgfmt section,
+  which the linker script keeps out of Flash, and its offset in that
+  section becomes a token.  The call writes a marker byte, the token
+  and the raw arguments into the dmesg buffer.
+
+  bin/dmesg-tokens.py collects the section from goodwatch.elf into a
+  dictionary at build time, and bin/dmesg-decode.py uses that
+  dictionary to render the buffer as text on the host.
+
+  The argument types are worked out at compile time with _Generic,
+  two bits each, so the watch never parses a format string.  At most
+  eight arguments are supported, and floating point is not.
+*/
+
+#ifndef DMESGTOK_H
+#define DMESGTOK_H
+#ifdef DMESG_TOKENS
+
+#include <stdint.h>
+#include "printf.h"
+
+//! Begins a token record in the dmesg buffer.  Text never uses it.
+#define DMESG_TOKENMARK 0xFF
+
+//! Argument types, packed two bits per argument with the first lowest.
+#define DMESG_ARGEND 0
+#define DMESG_ARG16  1
+#define DMESG_ARG32  2
+#define DMESG_ARGSTR 3
+
+//! Type of a single argument.
+#define DMESG_ARGTYPE(x) _Generic((x),                       \
+    char*: DMESG_ARGSTR, const char*: DMESG_ARGSTR,         \
+    long: DMESG_ARG32, unsigned long: DMESG_ARG32,          \
+    default: DMESG_ARG16)
+
+#define DMESG_T0() DMESG_ARGEND
+/* Floating point has no type of its own, and would be logged as 16
+   bits of garbage, so it is refused when the call is compiled.
+ */
+#define DMESG_T1(a) ({                                              \
+      _Static_assert(!_Generic((a), float: 1, double: 1,            \
+                               long double: 1, default: 0),         \
+                     "dmesg tokens can't log floating point.");     \
+      DMESG_ARGTYPE(a);                                             \
+    })
+#define DMESG_T2(a,...) (DMESG_T1(a)|DMESG_T1(__VA_ARGS__)<<2)
+#define DMESG_T3(a,...) (DMESG_T1(a)|DMESG_T2(__VA_ARGS__)<<2)
+#define DMESG_T4(a,...) (DMESG_T1(a)|DMESG_T3(__VA_ARGS__)<<2)
+#define DMESG_T5(a,...) (DMESG_T1(a)|DMESG_T4(__VA_ARGS__)<<2)
+#define DMESG_T6(a,...) (DMESG_T1(a)|DMESG_T5(__VA_ARGS__)<<2)
+#define DMESG_T7(a,...) (DMESG_T1(a)|DMESG_T6(__VA_ARGS__)<<2)
+#define DMESG_T8(a,...) (DMESG_T1(a)|DMESG_T7(__VA_ARGS__)<<2)
+#define DMESG_NTH(_0,_1,_2,_3,_4,_5,_6,_7,_8,N,...) N
+
+//! Packed types of all arguments, or DMESG_ARGEND for none.
+#define DMESG_TYPES(...)                                        \
+  DMESG_NTH(_, ##__VA_ARGS__, DMESG_T8, DMESG_T7, DMESG_T6,      \
+            DMESG_T5, DMESG_T4, DMESG_T3, DMESG_T2, DMESG_T1,    \
+            DMESG_T0)(__VA_ARGS__)
+
+//! Token of a format string, which is its offset in .dmesgfmt.
+#define DMESG_TOKEN(fmt) ({                                         \
+      static const char dmesg_fmt[]                                 \
+        __attribute__ ((section (".dmesgfmt"))) = fmt;              \
+      (uint16_t) dmesg_fmt;                                         \
+    })
+
+//! Writes a token record to the dmesg buffer.
+void dmesg_token(uint16_t token, uint16_t types, ...);
+
+#undef printf
+#define printf(fmt, ...)                                            \
+  dmesg_token(DMESG_TOKEN(fmt), DMESG_TYPES(__VA_ARGS__), ##__VA_ARGS__)
+
+#endif
+#endif
@@ -0,0 +1,301 @@
+/*! \file appsim.c
+  \brief Scripted applet simulator.
+
+  This boots the real applet table on the host, by way of watch.c,
+  and plays a script of keypresses and quarter-second frames against
+  it.  It's fast enough to walk every applet in a fraction of a
+  second, so UI logic can be tested without a watch, and it counts the
+  work of each frame: firmware function calls, register accesses and
+  bytes of LCD memory changed.
+
+  Usage: appsim [-v] [-t trace] [script]
+
+  The script is read from stdin if no file is given.  Each line holds
+  one command, and # begins a comment.
+
+  time hh:mm:ss   sets the RTC.
+  date yyyy-mm-dd sets the calendar and the day of the week.
+  frames n        runs n quarter-second frames.
+  key c           presses c for a frame, then lets it go.
+  press c         presses and holds c.
+  release         lets go of the keypad.
+  mode            holds the Mode button for a frame, then lets it
+                  go for another.
+  set             holds the Set button for a second, which the clock
+                  needs to notice it.
+  expect text     fails unless the LCD, as lcdview.c renders it,
+                  begins with text.
+  applet name     fails unless the named applet is active.
+  vcc n           sets the battery to n hundredths of a volt, as the
+                  ADC will next read it.
+
+  With -v, every frame is printed.  A summary by applet is printed at
+  the end, and the exit code is the count of failed expectations.
+
+  With -t, an activity trace is written for bin/energymodel.py, one
+  line per frame.  It holds the cycles of the frame, those that were
+  active, calls and wakeups, then the cycles spent with the radio in
+  IDLE, RX and TX, and with the reference, ADC, buzzer and LCD charge
+  pump turned on.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "hal.h"
+#include "lcdview.h"
+#include "watch.h"
+#include "cc1101.h"
+#include "api.h"
+
+//! Most applets we'll summarize.
+#define APPSIM_MAXAPPS 32
+
+//! Work done by one applet, over all of its frames.
+struct appstats {
+  const char *name;
+  uint32_t frames;
+  uint32_t calls, maxcalls;
+  uint32_t regs, maxregs;
+  uint32_t lcdbytes, maxlcdbytes;
+};
+static struct appstats stats[APPSIM_MAXAPPS];
+
+//! Set to print every frame.
+static int verbose=0;
+//! Frames run so far.
+static uint32_t framecount=0;
+
+//! Activity trace, or NULL.
+static FILE *trace=NULL;
+
+//! Counters at the end of the last frame.
+static uint32_t lastcalls, lastregs, lastwakeups;
+static uint64_t lastcycles, lastsleep, lastontime[HAL_POWERCOUNT];
+static uint64_t lastresidency[CC1101_POWERSTATES];
+//! LCD memory at the end of the last frame.
+static uint8_t lastlcd[HAL_LCDMLEN];
+
+//! Returns the stats of an applet, adding it if need be.
+static struct appstats *appstats(const char *name){
+  int i;
+
+  for(i=0; i<APPSIM_MAXAPPS && stats[i].name; i++)
+    if(!strcmp(stats[i].name, name))
+      return &stats[i];
+  if(i==APPSIM_MAXAPPS){
+    printf("Too many applets to summarize.\n");
+    exit(1);
+  }
+  stats[i].name=name;
+  return &stats[i];
+}
+
+//! Remembers the counters, so that the next frame counts from here.
+static void mark(){
+  lastcalls=watch_calls;
+  lastregs=hal_totalaccesses();
+  lastwakeups=hal_wakeups;
+  lastcycles=hal_cycles;
+  lastsleep=hal_sleepcycles;
+  memcpy(lastontime, hal_ontime, sizeof(lastontime));
+  memcpy(lastresidency, cc1101_residency, sizeof(lastresidency));
+}
+
+//! Writes the trace line of a frame.
+static void traceframe(const char *name, uint32_t calls){
+  uint64_t cycles=hal_cycles-lastcycles;
+  int i;
+
+  //Applet names have spaces, which would split the column.
+  fprintf(trace, "%u ", framecount);
+  for(i=0; name[i]; i++)
+    fputc(name[i]==' ' ? '_' : name[i], trace);
+  fprintf(trace, " %llu %llu %u %u %u",
+          (unsigned long long) cycles,
+          (unsigned long long) (cycles-(hal_sleepcycles-lastsleep)),
+          calls, hal_wakeups-lastwakeups, hal_mclk);
+  for(i=CC1101_POWER_IDLE; i<CC1101_POWERSTATES; i++)
+    fprintf(trace, " %llu",
+            (unsigned long long) (cc1101_residency[i]-lastresidency[i]));
+  for(i=0; i<HAL_POWERCOUNT; i++)
+    fprintf(trace, " %llu",
+            (unsigned long long) (hal_ontime[i]-lastontime[i]));
+  fputc('\n', trace);
+}
+
+//! Charges the work since the last frame to the active applet.
+static void account(){
+  struct appstats *s=appstats(applet->name ? applet->name : "?");
+  uint32_t calls=watch_calls-lastcalls;
+  uint32_t regs=hal_totalaccesses()-lastregs;
+  uint32_t lcdbytes=0;
+  volatile uint8_t *lcd=&LCDM1;
+  char text[LCDVIEW_LEN];
+  int i;
+
+  for(i=0; i<HAL_LCDMLEN; i++){
+    if(lcd[i]!=lastlcd[i])
+      lcdbytes++;
+    lastlcd[i]=lcd[i];
+  }
+
+  s->frames++;
+  s->calls+=calls;
+  s->regs+=regs;
+  s->lcdbytes+=lcdbytes;
+  if(calls>s->maxcalls)
+    s->maxcalls=calls;
+  if(regs>s->maxregs)
+    s->maxregs=regs;
+  if(lcdbytes>s->maxlcdbytes)
+    s->maxlcdbytes=lcdbytes;
+
+  if(verbose){
+    lcdview_text(text);
+    printf("%6u %-10s %6u calls %6u regs %3u lcd  %s\n",
+           framecount, s->name, calls, regs, lcdbytes, text);
+  }
+  if(trace)
+    traceframe(s->name, calls);
+
+  mark();
+}
+
+//! Runs one quarter-second frame, including anything queued before it.
+static void frame(){
+  //A frame that runs for two seconds is stuck.
+  hal_deadline=hal_cycles+2*hal_mclk;
+  hal_sleep(hal_mclk/4);
+  watch_frame();
+  framecount++;
+  account();
+}
+
+//! Prints the work of each applet.
+static void summary(){
+  int i;
+
+  printf("%-10s %6s %10s %8s %10s %8s %8s\n", "applet", "frames",
+         "calls/fr", "max", "regs/fr", "max", "lcd/fr");
+  for(i=0; i<APPSIM_MAXAPPS && stats[i].name; i++)
+    printf("%-10s %6u %10.1f %8u %10.1f %8u %8.1f\n", stats[i].name,
+           stats[i].frames,
+           (double) stats[i].calls/stats[i].frames, stats[i].maxcalls,
+           (double) stats[i].regs/stats[i].frames, stats[i].maxregs,
+           (double) stats[i].lcdbytes/stats[i].frames);
+}
+
+//! Runs one line of the script, returning the count of failures.
+static int command(char *line, int lineno){
+  char *cmd, *arg;
+  char text[LCDVIEW_LEN];
+  int a, b, c, n;
+
+  //Commands are a word, then everything after a single space.
+  if((arg=strchr(line, '#')))
+    *arg=0;
+  line[strcspn(line, "\r\n")]=0;
+  cmd=line+strspn(line, " \t");
+  if(!*cmd)
+    return 0;
+  arg=cmd+strcspn(cmd, " \t");
+  if(*arg)
+    *arg++=0;
+
+  if(!strcmp(cmd, "time") && sscanf(arg, "%d:%d:%d", &a, &b, &c)==3){
+    RTCHOUR=a;
+    RTCMIN=b;
+    RTCSEC=c;
+  }else if(!strcmp(cmd, "date") && sscanf(arg, "%d-%d-%d", &a, &b, &c)==3){
+    RTCYEAR=a;
+    RTCMON=b;
+    RTCDAY=c;
+    rtc_setdow();
+  }else if(!strcmp(cmd, "frames")){
+    for(n=atoi(arg); n>0; n--)
+      frame();
+  }else if(!strcmp(cmd, "key") && *arg){
+    watch_key(*arg);
+    frame();
+    watch_key(0);
+  }else if(!strcmp(cmd, "press") && *arg){
+    watch_key(*arg);
+  }else if(!strcmp(cmd, "release")){
+    watch_key(0);
+  }else if(!strcmp(cmd, "mode")){
+    //Mode only acts on its first frame, so a press must end.
+    watch_sidebuttons(BIT5);
+    frame();
+    watch_sidebuttons(0);
+    frame();
+  }else if(!strcmp(cmd, "set")){
+    //The applets wait for Set to be let go, so it lets go by itself.
+    watch_sidebuttons(BIT6);
+    hal_release=hal_cycles+hal_mclk;
+    while(hal_release)
+      frame();
+  }else if(!strcmp(cmd, "vcc") && *arg){
+    watch_vcc=atoi(arg);
+  }else if(!strcmp(cmd, "expect")){
+    lcdview_text(text);
+    if(strncmp(text, arg, strlen(arg))){
+      printf("Line %d: expected %s but the LCD shows %s.\n",
+             lineno, arg, text);
+      return 1;
+    }
+  }else if(!strcmp(cmd, "applet")){
+    if(!applet->name || strcmp(applet->name, arg)){
+      printf("Line %d: expected the %s applet but %s is active.\n",
+             lineno, arg, applet->name ? applet->name : "none");
+      return 1;
+    }
+  }else{
+    printf("Line %d: unknown command '%s'.\n", lineno, cmd);
+    exit(1);
+  }
+  return 0;
+}
+
+//! Unix command-line tool for scripting the applets.
+int main(int argc, char **argv){
+  struct tm tm={.tm_hour=12, .tm_mday=1, .tm_mon=0, .tm_year=118};
+  FILE *script=stdin;
+  char line[256];
+  int opt, lineno=0, failures=0;
+
+  while((opt=getopt(argc, argv, "vt:"))!=-1){
+    switch(opt){
+    case 'v': verbose=1; break;
+    case 't':
+      if(!(trace=fopen(optarg, "w"))){
+        perror(optarg);
+        return 1;
+      }
+      fprintf(trace, "# frame applet cycles active calls wakeups mclk"
+              " radioidle radiorx radiotx ref adc buzzer lcdcp\n");
+      break;
+    default:
+      fprintf(stderr, "Usage: %s [-v] [-t trace] [script]\n", argv[0]);
+      return 1;
+    }
+  }
+  if(optind<argc && !(script=fopen(argv[optind], "r"))){
+    perror(argv[optind]);
+    return 1;
+  }
+
+  //Boot on the same day every time, so that the scripts repeat.
+  watch_echo=0;
+  watch_boot(&tm);
+  mark();
+
+  while(fgets(line, sizeof(line), script))
+    failures+=command(line, ++lineno);
+
+  summary();
+  if(failures)
+    printf("%d expectations failed.\n", failures);
+  return failures;
+}
@@ -0,0 +1,2 @@
+//! Host builds are always made at noon on New Year's Day of 2018.
+#define BUILDTIME "\x0c\x00\x00\xff\xe2\x07\x01\x01"
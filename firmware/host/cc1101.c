@@ -0,0 +1,813 @@
+/*! \file cc1101.c
+  \brief Software model of the CC430's RF1A radio core.
+
+  This is a byte-level model of the CC1101 core that lives inside the
+  CC430F6137, just detailed enough to exercise radio.c, packet.c and
+  the radio applets on a workstation.  It covers:
+
+  1) The instruction interface of RF1AINSTRB, RF1ADINB, RF1ADOUTB and
+  friends, with single and burst register access, the PATABLE, status
+  registers and strobes.
+
+  2) The MARC state machine for IDLE, RX, TX, FSTXON, XOFF and the
+  FIFO error states, with RXOFF_MODE and TXOFF_MODE in MCSM1.
+
+  3) Both 64-byte FIFOs, with fixed, variable and infinite packet
+  lengths, preamble and sync, address filtering, and appended status
+  bytes.  CRC bytes take their airtime but are not computed.
+
+  4) The RFIFG interrupt signals, with edge selection by RF1AIES and
+  the RF1AIV vector.  RFIFG9 is end of packet and RFIFG2 is the TX
+  FIFO threshold, as in TI's examples.
+
+  Time is counted in CPU cycles from hal.c, one byte clock at a time,
+  with the bitrate taken from MDMCFG4 and MDMCFG3.  Received packets
+  come from cc1101_air(), which plays raw bytes at that same rate,
+  and the receiver finds the sync word only on byte boundaries.  Sent
+  packets are logged in cc1101_sent[] for the tests to check.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "cc1101.h"
+
+//! Size of each FIFO.
+#define FIFOLEN 64
+//! Bytes of air traffic that may be queued.
+#define AIRLEN 8192
+
+//MARC states that the model uses.
+#define SLEEP 0
+#define IDLE 1
+#define XOFF 2
+#define RX 13
+#define RXOVERFLOW 17
+#define FSTXON 18
+#define TX 19
+#define TXUNDERFLOW 22
+
+//! Frames sent since cc1101_reset(), the first CC1101_LOGLEN of which are logged.
+int cc1101_sentcount;
+struct cc1101_frame cc1101_sent[CC1101_LOGLEN];
+//! Counts of instructions, strobes and FIFO bytes through the core interface.
+uint32_t cc1101_instructions, cc1101_strobes, cc1101_fifobytes;
+//! RSSI and LQI bytes appended to received packets.
+uint8_t cc1101_rssi=0xD0, cc1101_lqi=0x10;
+//! Cycles spent in each power state since cc1101_reset().
+uint64_t cc1101_residency[CC1101_POWERSTATES];
+
+//! Reset values of the configuration registers, from the datasheet.
+static const uint8_t defaults[0x2F]={
+  0x29, 0x2E, 0x3F, 0x07, 0xD3, 0x91, 0xFF, 0x04,
+  0x45, 0x00, 0x00, 0x0F, 0x00, 0x1E, 0xC4, 0xEC,
+  0x8C, 0x22, 0x02, 0x22, 0xF8, 0x47, 0x07, 0x30,
+  0x04, 0x36, 0x6C, 0x03, 0x40, 0x91, 0x87, 0x6B,
+  0xF8, 0x56, 0x10, 0xA9, 0x0A, 0x20, 0x0D, 0x41,
+  0x00, 0x59, 0x7F, 0x3F, 0x88, 0x31, 0x0B
+};
+
+//! Preamble bytes for each NUM_PREAMBLE setting of MDMCFG1.
+static const uint8_t preambles[8]={2, 3, 4, 6, 8, 12, 16, 24};
+
+static uint8_t regs[0x2F];
+static uint8_t patable[8];
+static int paindex;
+static int marcstate;
+
+static uint8_t txfifo[FIFOLEN], rxfifo[FIFOLEN];
+static int txcount, rxcount;
+
+//Instruction interface.
+static uint8_t dout, statb;
+static uint16_t ifctl;
+//! Address awaiting data or auto-reads, or -1.
+static int instaddr=-1;
+static int instburst, instread;
+
+//Interrupts.
+static uint16_t ifg, ie, ies, signals, lastvector;
+
+//Byte clock.
+static int clockrunning;
+static uint64_t nextbyte;
+
+//Transmitter.
+static struct cc1101_frame txframe;
+static int txpreamble, txinpacket, txlength, txcrc;
+
+//Receiver.
+static uint32_t window;
+static int synced, rxpos, rxlength, rxstart, rxcrc;
+
+//Air.
+static uint8_t air[AIRLEN];
+static int airhead, airtail;
+
+//! Cycle up to which residency has been counted.
+static uint64_t lastrun;
+
+
+//! Local function to return the byte time in CPU cycles.
+static uint64_t bytetime(){
+  double rate=(256.0+regs[MDMCFG3])*(1<<(regs[MDMCFG4]&0x0F))
+    *26000000.0/(1<<28);
+  uint64_t cycles=hal_mclk*8.0/rate;
+
+  return cycles ? cycles : 1;
+}
+
+//! Local function, true if the chip is asleep.
+static int asleep(){
+  return marcstate==SLEEP || marcstate==XOFF;
+}
+
+//! Local function, true if the byte clock has work to do.
+static int clockneeded(){
+  return airhead!=airtail || marcstate==TX || (marcstate==RX && synced);
+}
+
+//! Local function to start the byte clock if it's needed.
+static void clockcheck(){
+  if(!clockrunning && clockneeded()){
+    clockrunning=1;
+    nextbyte=hal_cycles+bytetime();
+  }
+}
+
+//! Local function to update the RFIFG signals and latch their edges.
+static void updatesignals(){
+  int rxthr=4*((regs[FIFOTHR]&0x0F)+1);
+  int txthr=65-rxthr;
+  uint16_t sig=0, changed;
+
+  if(rxcount>=rxthr)
+    sig|=BIT0|BIT1;
+  if(txcount>=txthr)
+    sig|=BIT2;
+  if(txcount==FIFOLEN)
+    sig|=BIT3;
+  if(marcstate==RXOVERFLOW)
+    sig|=BIT4;
+  if(marcstate==TXUNDERFLOW)
+    sig|=BIT5;
+  if((marcstate==RX && synced) || (marcstate==TX && txinpacket))
+    sig|=BIT9;
+
+  //RF1AIES selects falling edges when set, rising edges when clear.
+  changed=sig^signals;
+  ifg|=(changed&sig&~ies) | (changed&~sig&ies);
+  signals=sig;
+}
+
+//! Local function for the chip status byte.
+static uint8_t status(int read){
+  uint8_t state;
+
+  switch(marcstate){
+  case RX:          state=1; break;
+  case TX:          state=2; break;
+  case FSTXON:      state=3; break;
+  case RXOVERFLOW:  state=6; break;
+  case TXUNDERFLOW: state=7; break;
+  default:          state=0; break;
+  }
+  return (asleep()?0x80:0) | (state<<4)
+    | (read ? (rxcount>15?15:rxcount) : (FIFOLEN-txcount>15?15:FIFOLEN-txcount));
+}
+
+//! Local function to read a status register.
+static uint8_t statusreg(uint8_t addr){
+  switch(addr){
+  case PARTNUM:   return 0x00;
+  case VERSION:   return 0x06;
+  case LQI:       return cc1101_lqi|0x80;
+  case RSSI:      return cc1101_rssi;
+  case MARCSTATE: return marcstate;
+  case PKTSTATUS: return (signals&BIT9) ? 0x01 : 0x00;
+  case TXBYTES:   return txcount|(marcstate==TXUNDERFLOW?0x80:0);
+  case RXBYTES:   return rxcount|(marcstate==RXOVERFLOW?0x80:0);
+  }
+  return 0;
+}
+
+//! Pops a byte from the RX FIFO for the DMA controller.
+uint8_t cc1101_rxpop(){
+  uint8_t byte;
+
+  if(!rxcount){
+    printf("cc1101: Read from an empty RX FIFO.\n");
+    return 0;
+  }
+  byte=rxfifo[0];
+  memmove(rxfifo, rxfifo+1, --rxcount);
+  cc1101_fifobytes++;
+  updatesignals();
+  return byte;
+}
+
+//! Pushes a byte into the TX FIFO for the DMA controller.
+void cc1101_txpush(uint8_t byte){
+  if(txcount==FIFOLEN){
+    printf("cc1101: Write to a full TX FIFO.\n");
+    return;
+  }
+  txfifo[txcount++]=byte;
+  cc1101_fifobytes++;
+  updatesignals();
+}
+
+//! DMA trigger levels, RFRXIFG and RFTXIFG.
+int cc1101_rxready(){
+  return rxcount>0;
+}
+int cc1101_txready(){
+  return txcount<FIFOLEN;
+}
+
+//! Local function to begin a frame from the TX FIFO.
+static void txbegin(uint64_t now){
+  int syncmode=regs[MDMCFG2]&7;
+
+  marcstate=TX;
+  memset(&txframe, 0, sizeof(txframe));
+  txframe.start=now;
+  txlength=-1;
+  txcrc=0;
+
+  //Sync modes 0 and 4 send neither preamble nor sync.
+  if(syncmode==0 || syncmode==4){
+    txpreamble=0;
+    txinpacket=1;
+  }else{
+    txpreamble=preambles[(regs[MDMCFG1]>>4)&7]
+      + ((syncmode==3 || syncmode==7) ? 4 : 2);
+    txinpacket=0;
+  }
+  clockcheck();
+}
+
+//! Local function to begin listening.
+static void rxbegin(){
+  marcstate=RX;
+  synced=0;
+  window=0;
+}
+
+//! Local function to enter IDLE, abandoning any packet.
+static void idle(){
+  marcstate=IDLE;
+  synced=0;
+  txinpacket=0;
+}
+
+//! Local function to leave RX or TX by an OFF_MODE setting of MCSM1.
+static void offmode(int mode, uint64_t now){
+  switch(mode){
+  case 0: idle(); break;
+  case 1: idle(); marcstate=FSTXON; break;
+  case 2: txbegin(now); break;
+  case 3: rxbegin(); break;
+  }
+}
+
+//! Local function to log a finished frame.
+static void txlog(uint64_t now, int underflow){
+  txframe.end=now;
+  txframe.underflow=underflow;
+  if(cc1101_sentcount<CC1101_LOGLEN)
+    cc1101_sent[cc1101_sentcount]=txframe;
+  cc1101_sentcount++;
+}
+
+//! Local function to send one byte time.
+static void txbyte(uint64_t now){
+  int lenconf=regs[PKTCTRL0]&3;
+  uint8_t byte;
+
+  if(txpreamble){
+    //Preamble and sync come from the packet engine, not the FIFO.
+    if(!--txpreamble)
+      txinpacket=1;
+    return;
+  }
+
+  if(txcrc){
+    //CRC bytes come from the packet engine, too.
+    if(--txcrc)
+      return;
+  }else{
+    if(!txcount){
+      //Running dry is the normal end of an infinite packet.
+      marcstate=TXUNDERFLOW;
+      txinpacket=0;
+      txlog(now, 1);
+      return;
+    }
+    byte=txfifo[0];
+    memmove(txfifo, txfifo+1, --txcount);
+    if(txframe.length<CC1101_MAXFRAME)
+      txframe.data[txframe.length]=byte;
+    txframe.length++;
+
+    if(txframe.length==1)
+      txlength = lenconf==1 ? byte+1 : lenconf==0 ? regs[PKTLEN] : -1;
+    if(txframe.length!=txlength)
+      return;
+    if(regs[PKTCTRL0]&0x04){
+      txcrc=2;
+      return;
+    }
+  }
+
+  /* The end of packet must be seen as an edge, even if TXOFF_MODE
+     starts the next packet right away.
+   */
+  txinpacket=0;
+  txlog(now, 0);
+  updatesignals();
+  offmode(regs[MCSM1]&3, now);
+}
+
+//! Local function to end a received packet.
+static void rxend(uint64_t now){
+  //Appended status needs room in the FIFO like anything else.
+  if(regs[PKTCTRL1]&0x04){
+    if(rxcount+2>FIFOLEN){
+      marcstate=RXOVERFLOW;
+      synced=0;
+      return;
+    }
+    rxfifo[rxcount++]=cc1101_rssi;
+    rxfifo[rxcount++]=cc1101_lqi|0x80;  //CRC_OK
+  }
+  synced=0;
+  window=0;
+  updatesignals();
+  offmode((regs[MCSM1]>>2)&3, now);
+}
+
+//! Local function to receive one byte time.
+static void rxbyte(int have, uint8_t byte, uint64_t now){
+  int syncmode=regs[MDMCFG2]&7;
+  int lenconf=regs[PKTCTRL0]&3;
+  int adrchk=regs[PKTCTRL1]&3;
+  uint16_t sync=(regs[SYNC1]<<8)|regs[SYNC0];
+  int ok;
+
+  if(!synced){
+    if(!have){
+      window=0;
+      return;
+    }
+    window=(window<<8)|byte;
+
+    //No sync detection is modeled for carrier-sense modes.
+    if(syncmode==0 || syncmode==4)
+      return;
+    if((syncmode==3 || syncmode==7)
+       ? window==(((uint32_t) sync<<16)|sync)
+       : (window&0xFFFF)==sync){
+      synced=1;
+      rxpos=0;
+      rxstart=rxcount;
+      rxlength=-1;
+      rxcrc=0;
+    }
+    return;
+  }
+
+  //Once synced, we demodulate noise if the transmitter stops.
+  if(!have)
+    byte=0x00;
+
+  if(rxpos==0){
+    if(lenconf==1 && byte>regs[PKTLEN]){
+      synced=0;
+      window=0;
+      return;
+    }
+    rxlength = lenconf==1 ? byte+1 : lenconf==0 ? regs[PKTLEN] : -1;
+    rxcrc = (regs[PKTCTRL0]&0x04) ? 2 : 0;
+  }
+
+  if(rxlength<0 || rxpos<rxlength){
+    if(adrchk && rxpos==(lenconf==1?1:0)){
+      ok = byte==regs[ADDR]
+        || (adrchk>=2 && byte==0x00)
+        || (adrchk==3 && byte==0xFF);
+      if(!ok){
+        //Discarded packets are rolled back out of the FIFO.
+        rxcount=rxstart;
+        synced=0;
+        window=0;
+        return;
+      }
+    }
+    if(rxcount==FIFOLEN){
+      marcstate=RXOVERFLOW;
+      synced=0;
+      return;
+    }
+    rxfifo[rxcount++]=byte;
+    rxpos++;
+    if(rxpos==rxlength && !rxcrc)
+      rxend(now);
+  }else if(rxcrc){
+    if(!--rxcrc)
+      rxend(now);
+  }
+}
+
+//! Local function for one tick of the byte clock.
+static void bytetick(uint64_t now){
+  int have=0;
+  uint8_t byte=0;
+
+  if(airhead!=airtail){
+    have=1;
+    byte=air[airhead++];
+    if(airhead==airtail)
+      airhead=airtail=0;
+  }
+
+  if(marcstate==RX)
+    rxbyte(have, byte, now);
+  else if(marcstate==TX)
+    txbyte(now);
+  updatesignals();
+}
+
+//! Local function, the power state that draws like the MARC state.
+static int powerstate(){
+  switch(marcstate){
+  case SLEEP:
+  case XOFF:
+    return CC1101_POWER_SLEEP;
+  case RX:
+    return CC1101_POWER_RX;
+  case FSTXON:
+  case TX:
+    return CC1101_POWER_TX;
+  default:
+    return CC1101_POWER_IDLE;
+  }
+}
+
+//! Local function to charge the cycles up to now to the current state.
+static void reside(uint64_t now){
+  if(now>lastrun){
+    cc1101_residency[powerstate()]+=now-lastrun;
+    lastrun=now;
+  }
+}
+
+//! Runs the radio up to the given cycle.
+void cc1101_run(uint64_t now){
+  while(clockrunning && nextbyte<=now){
+    reside(nextbyte);
+    bytetick(nextbyte);
+    if(clockneeded())
+      nextbyte+=bytetime();
+    else
+      clockrunning=0;
+  }
+  reside(now);
+}
+
+//! Cycle of the next scheduled event, or UINT64_MAX if none.
+uint64_t cc1101_nextevent(){
+  return clockrunning ? nextbyte : UINT64_MAX;
+}
+
+//! Local function for the strobes.
+static void strobe(uint8_t s){
+  cc1101_strobes++;
+  paindex=0;
+
+  //Anything but a sleep strobe wakes the chip.
+  if(asleep() && s!=RF_SXOFF && s!=RF_SPWD && s!=RF_SWOR)
+    marcstate=IDLE;
+
+  switch(s){
+  case RF_SRES:
+    memcpy(regs, defaults, sizeof(regs));
+    memset(patable, 0, sizeof(patable));
+    txcount=rxcount=0;
+    idle();
+    break;
+  case RF_SFSTXON:
+    if(marcstate==IDLE)
+      marcstate=FSTXON;
+    break;
+  case RF_SXOFF:
+    if(marcstate==IDLE)
+      marcstate=XOFF;
+    break;
+  case RF_SCAL:
+    //Calibration is instantaneous here.
+    break;
+  case RF_SRX:
+    if(marcstate==IDLE || marcstate==FSTXON || marcstate==TX)
+      rxbegin();
+    break;
+  case RF_STX:
+    if(marcstate==IDLE || marcstate==FSTXON || marcstate==RX)
+      txbegin(hal_cycles);
+    break;
+  case RF_SIDLE:
+    if(!asleep())
+      idle();
+    break;
+  case RF_SPWD:
+    if(marcstate==IDLE)
+      marcstate=SLEEP;
+    break;
+  case RF_SFRX:
+    if(marcstate==IDLE || marcstate==RXOVERFLOW){
+      rxcount=0;
+      marcstate=IDLE;
+    }
+    break;
+  case RF_SFTX:
+    if(marcstate==IDLE || marcstate==TXUNDERFLOW){
+      txcount=0;
+      marcstate=IDLE;
+    }
+    break;
+  }
+  clockcheck();
+}
+
+//! Local function to read from an address of the core.
+static uint8_t readaddr(int addr){
+  if(addr<0x2F)
+    return regs[addr];
+  if(addr==PATABLE)
+    return patable[paindex++&7];
+  if(addr==RXFIFO)
+    return rxcount ? cc1101_rxpop() : 0;
+  return 0;
+}
+
+//! Local function for a data byte written through RF1ADINB.
+static void data(uint8_t byte){
+  int addr=instaddr;
+
+  if(addr<0 || instread)
+    return;
+  if(addr==TXFIFO)
+    cc1101_txpush(byte);
+  else if(addr==PATABLE)
+    patable[paindex++&7]=byte;
+  else if(addr<0x2F)
+    regs[addr]=byte;
+
+  //Bursts continue to the next register, except for the FIFO and PATABLE.
+  if(!instburst)
+    instaddr=-1;
+  else if(addr<0x2F)
+    instaddr++;
+  statb=status(0);
+}
+
+//! Local function for a byte written to the instruction register.
+static void instruction(uint8_t instr){
+  int addr=instr&0x3F;
+  int read=instr&0x80;
+  int burst=instr&0x40;
+
+  cc1101_instructions++;
+  statb=status(read);
+  ifctl|=RFSTATIFG;
+
+  if(addr>=0x30 && addr<=0x3D){
+    if(read && burst){
+      dout=statusreg(addr);
+      ifctl|=RFDOUTIFG;
+      instaddr=-1;
+    }else{
+      strobe(addr);
+      statb=status(read);
+    }
+    return;
+  }
+
+  instaddr=addr;
+  instburst=burst;
+  instread=read;
+  if(read){
+    /* Without auto-read, the data would wait for a dummy write to
+       RF1ADINB, but we simply have it ready in either case.
+     */
+    dout=readaddr(addr);
+    ifctl|=RFDOUTIFG;
+    if(!burst)
+      instaddr=-1;
+    else if(addr<0x2F)
+      instaddr++;
+  }
+}
+
+//! Value presented to the firmware when it touches a register.
+uint32_t cc1101_regread(int reg){
+  uint16_t pending;
+  int i;
+
+  switch(reg){
+  case HAL_RF1AIFCTL1:
+    return RFINSTRIFG|RFDINIFG|ifctl
+      | (rxcount?RFRXIFG:0) | (txcount<FIFOLEN?RFTXIFG:0);
+  case HAL_RF1ASTATB:
+    return statb;
+  case HAL_RF1ADOUTB:
+  case HAL_RF1ADOUT0B:
+  case HAL_RF1ADOUT1B:
+    return dout;
+  case HAL_RF1AIN:
+    //GDO2 is CHIP_RDYn during strobes, high while the chip sleeps.
+    return asleep() ? 0x04 : 0x00;
+  case HAL_RF1AIFG:
+    return ifg;
+  case HAL_RF1AIE:
+    return ie;
+  case HAL_RF1AIES:
+    return ies;
+  case HAL_RF1AIV:
+    pending=ifg&ie;
+    lastvector=0;
+    for(i=0; i<16; i++){
+      if(pending&(1<<i)){
+        lastvector=1<<i;
+        return 2*(i+1);
+      }
+    }
+    return 0;
+  }
+  return HAL_UNWRITTEN;
+}
+
+//! Called when the firmware has written a register.
+void cc1101_regwrite(int reg, uint32_t value){
+  switch(reg){
+  case HAL_RF1AIFCTL1:
+    //Only the interface flags may be cleared by software.
+    ifctl&=value|~(RFSTATIFG|RFDOUTIFG);
+    break;
+  case HAL_RF1AINSTRB:
+  case HAL_RF1AINSTR1B:
+    instruction(value&0xFF);
+    break;
+  case HAL_RF1AINSTRW:
+    instruction((value>>8)&0xFF);
+    data(value&0xFF);
+    break;
+  case HAL_RF1ADINB:
+    data(value&0xFF);
+    break;
+  case HAL_RF1AIFG:
+    ifg=value;
+    break;
+  case HAL_RF1AIE:
+    ie=value;
+    break;
+  case HAL_RF1AIES:
+    ies=value;
+    break;
+  }
+  updatesignals();
+  clockcheck();
+}
+
+//! Called when the firmware has read a register.
+void cc1101_regdone(int reg){
+  switch(reg){
+  case HAL_RF1ASTATB:
+    ifctl&=~RFSTATIFG;
+    break;
+  case HAL_RF1ADOUTB:
+  case HAL_RF1ADOUT0B:
+    ifctl&=~RFDOUTIFG;
+    instaddr=-1;
+    break;
+  case HAL_RF1ADOUT1B:
+    //This read begins the next auto-read of a burst.
+    ifctl&=~RFDOUTIFG;
+    if(instaddr>=0 && instread){
+      dout=readaddr(instaddr);
+      ifctl|=RFDOUTIFG;
+      if(instaddr<0x2F)
+        instaddr++;
+    }
+    break;
+  case HAL_RF1AIV:
+    ifg&=~lastvector;
+    lastvector=0;
+    break;
+  }
+}
+
+//! Returns non-zero if an enabled interrupt is pending.
+int cc1101_irq(){
+  return (ifg&ie)!=0;
+}
+
+//! Power-on reset of the radio core.
+void cc1101_reset(){
+  memcpy(regs, defaults, sizeof(regs));
+  memset(patable, 0, sizeof(patable));
+  paindex=0;
+  txcount=rxcount=0;
+  dout=statb=0;
+  ifctl=0;
+  instaddr=-1;
+  ifg=ie=ies=signals=lastvector=0;
+  clockrunning=0;
+  airhead=airtail=0;
+  idle();
+
+  cc1101_sentcount=0;
+  cc1101_instructions=cc1101_strobes=cc1101_fifobytes=0;
+  memset(cc1101_residency, 0, sizeof(cc1101_residency));
+  lastrun=0;
+}
+
+//! Queues a transmission on the air, following any that are queued.
+void cc1101_air(const uint8_t *bytes, int length){
+  if(airtail+length>AIRLEN){
+    printf("cc1101: Too much traffic on the air.\n");
+    exit(1);
+  }
+  memcpy(air+airtail, bytes, length);
+  airtail+=length;
+  clockcheck();
+}
+
+//! Queues every transmission in a hex file.  Returns the count or -1.
+int cc1101_airfile(const char *filename){
+  /* Bytes are written in hex, with whitespace and # comments
+     ignored.  Blank lines separate transmissions, which are played
+     back-to-back.  See pocsag.rx for an example.
+   */
+  FILE *f=fopen(filename, "r");
+  uint8_t buf[AIRLEN];
+  char line[1024];
+  char *p, *end;
+  int len=0, count=0;
+  long byte;
+
+  if(!f){
+    printf("Can't open %s.\n", filename);
+    return -1;
+  }
+
+  while(fgets(line, sizeof(line), f)){
+    //Comment lines are skipped, but truly blank lines end a transmission.
+    if(strspn(line, " \t\r\n")==strlen(line)){
+      //A blank line ends the transmission.
+      if(len){
+        cc1101_air(buf, len);
+        count++;
+        len=0;
+      }
+      continue;
+    }
+    if((p=strchr(line, '#')))
+      *p=0;
+    for(p=line; ; p=end){
+      char pair[3]={0,0,0};
+      p+=strspn(p, " \t\r\n");
+      if(!*p)
+        break;
+      pair[0]=p[0];
+      pair[1]=p[1];
+      byte=strtol(pair, &end, 16);
+      if(end!=pair+2 || len==AIRLEN){
+        printf("Bad hex in %s: %s", filename, line);
+        fclose(f);
+        return -1;
+      }
+      buf[len++]=byte;
+      end=p+2;
+    }
+  }
+  if(len){
+    cc1101_air(buf, len);
+    count++;
+  }
+  fclose(f);
+  return count;
+}
+
+//! Returns non-zero while transmissions remain on the air.
+int cc1101_airbusy(){
+  return airhead!=airtail;
+}
+
+//! Returns a radio register, for inspection by tests.
+uint8_t cc1101_peek(uint8_t addr){
+  if(addr<0x2F)
+    return regs[addr];
+  return statusreg(addr);
+}
@@ -0,0 +1,74 @@
+/*! \file cc1101.h
+  \brief Software model of the CC430's RF1A radio core.
+*/
+
+#include <stdint.h>
+
+//! Longest packet that the model will log.
+#define CC1101_MAXFRAME 256
+//! Number of transmitted frames kept for inspection.
+#define CC1101_LOGLEN 64
+
+//! A frame sent by the radio.
+struct cc1101_frame {
+  uint64_t start;     //Cycle of the first preamble or data byte.
+  uint64_t end;       //Cycle just after the last byte.
+  int length;         //Payload bytes, not counting preamble or sync.
+  int underflow;      //Set if the TX FIFO ran dry during the frame.
+  uint8_t data[CC1101_MAXFRAME];
+};
+
+//! Frames sent since cc1101_reset(), the first CC1101_LOGLEN of which are logged.
+extern int cc1101_sentcount;
+extern struct cc1101_frame cc1101_sent[CC1101_LOGLEN];
+
+//! Counts of instructions, strobes and FIFO bytes through the core interface.
+extern uint32_t cc1101_instructions, cc1101_strobes, cc1101_fifobytes;
+
+//! RSSI and LQI bytes appended to received packets.
+extern uint8_t cc1101_rssi, cc1101_lqi;
+
+//! Power states of the core, coarse enough to give each a current.
+enum cc1101_power {
+  CC1101_POWER_SLEEP,  //SLEEP and XOFF.
+  CC1101_POWER_IDLE,   //IDLE, and the FIFO error states.
+  CC1101_POWER_RX,
+  CC1101_POWER_TX,     //TX, and FSTXON with its synthesizer running.
+  CC1101_POWERSTATES
+};
+//! Cycles spent in each power state since cc1101_reset().
+extern uint64_t cc1101_residency[CC1101_POWERSTATES];
+
+//! Power-on reset of the radio core.
+void cc1101_reset();
+//! Queues a transmission on the air, following any that are queued.
+void cc1101_air(const uint8_t *bytes, int length);
+//! Queues every transmission in a hex file.  Returns the count or -1.
+int cc1101_airfile(const char *filename);
+//! Returns non-zero while transmissions remain on the air.
+int cc1101_airbusy();
+
+//! Returns a radio register, for inspection by tests.
+uint8_t cc1101_peek(uint8_t addr);
+
+/* These are called by hal.c, and ought not be needed by tests. */
+
+//! Value presented to the firmware when it touches a register.
+uint32_t cc1101_regread(int reg);
+//! Called when the firmware has written a register.
+void cc1101_regwrite(int reg, uint32_t value);
+//! Called when the firmware has read a register.
+void cc1101_regdone(int reg);
+//! Runs the radio up to the given cycle.
+void cc1101_run(uint64_t now);
+//! Cycle of the next scheduled event, or UINT64_MAX if none.
+uint64_t cc1101_nextevent();
+//! Returns non-zero if an enabled interrupt is pending.
+int cc1101_irq();
+//! Pops a byte from the RX FIFO for the DMA controller.
+uint8_t cc1101_rxpop();
+//! Pushes a byte into the TX FIFO for the DMA controller.
+void cc1101_txpush(uint8_t byte);
+//! DMA trigger levels, RFRXIFG and RFTXIFG.
+int cc1101_rxready();
+int cc1101_txready();
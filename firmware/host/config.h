@@ -0,0 +1,10 @@
+/*! \file config.h
+  \brief Configuration for host builds without a firmware/config.h.
+
+  If you have your own firmware/config.h, it is used instead, and the
+  tests are written to pass either way.
+*/
+
+#define CALLSIGN "N0CALL"
+#define DAPNETRIC 0
+#define PHONEBOOK "Emulator" "555-1212" "\n"
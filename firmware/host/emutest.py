@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+# End to end test of bin/goodwatchlib.py against ./watchemu, which runs
+# the real monitor firmware on a pseudo-terminal.  Nothing here needs
+# a watch, so it runs with the radio tests under 'make run'.
+
+import os, sys, time, subprocess, threading, queue;
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                "..", "..", "bin"));
+from goodwatchlib import *;
+
+failures=0;
+def check(name, ok):
+    """Prints a test result, counting the failures."""
+    global failures;
+    print("%-40s %s" % (name, "PASS" if ok else "FAIL"));
+    if not ok:
+        failures+=1;
+
+class Emulator:
+    """Runs ./watchemu, collecting its LCD lines in the background."""
+    def __init__(self, args=[]):
+        self.proc=subprocess.Popen(["./watchemu","-q","-l"]+args,
+                                   stdout=subprocess.PIPE,
+                                   universal_newlines=True);
+        self.lcd=queue.Queue();
+        #The emulator prints its pty before anything else.
+        self.pty=self.proc.stdout.readline().strip();
+        while not self.pty.startswith("/dev/"):
+            self.pty=self.proc.stdout.readline().strip();
+        threading.Thread(target=self.readlines, daemon=True).start();
+    def readlines(self):
+        for line in self.proc.stdout:
+            if line.startswith("lcd "):
+                self.lcd.put(line[4:].strip());
+    def waitlcd(self, text, timeout=3):
+        """Returns True once the LCD begins with text."""
+        end=time.time()+timeout;
+        while time.time()<end:
+            try:
+                if self.lcd.get(timeout=0.1).startswith(text):
+                    return True;
+            except queue.Empty:
+                pass;
+        return False;
+    def stop(self):
+        self.proc.terminate();
+        self.proc.wait();
+
+def benchmark(watch, count=50):
+    """Returns PEEK transactions per second, keeping the window full."""
+    start=time.time();
+    reqs=[watch.submit(bytes([PEEK,0])+chr16(0x2400)) for i in range(count)];
+    for r in reqs:
+        watch.result(r);
+    return count/(time.time()-start);
+
+emu=Emulator();
+watch=GoodWatch("pty:"+emu.pty);
+
+check("Turbo mode", watch.turbomode(1) is not None);
+check("Switch to 115200 baud", watch.setbaud(115200));
+
+watch.lcdstring("emulated");
+check("LCDSTRING reaches the display", emu.waitlcd('"emulated"'));
+
+watch.poke(0x1C00, 0xBEEF);
+check("POKE then PEEK", watch.peek(0x1C00)==0xBEEF);
+
+block=bytes((i*7)&0xFF for i in range(1024));
+watch.write(0x1C00, block, verify=False);
+check("WRITE then READ of 1kB", watch.read(0x1C00, 1024)==block);
+check("READ of no bytes is refused",
+      watch.transact(bytes([READ,0])+chr16(0x1C00)+chr16(0))==bytes([READ]));
+
+check("dmesg shows the boot", b"Booted." in watch.dmesg());
+(epoch,seq,text)=watch.dmesgsince();
+(epoch2,seq2,text2)=watch.dmesgsince(epoch, seq+len(text));
+check("dmesg since the last read is empty",
+      epoch2==epoch and seq2==seq+len(text) and text2==b"");
+
+samples=watch.randint(100);
+check("RANDINT returns 100 samples", len(samples)==100);
+
+watch.window=1;
+serial=benchmark(watch);
+watch.window=2;
+pipelined=benchmark(watch);
+print("PEEKs per second at 115200 baud: %d with one in flight, %d with two."
+      % (serial, pipelined));
+
+#A host that starts over at 9600 garbles its first byte, and the
+#framing error brings the watch back to 9600 for the retry.
+watch.transport.close();
+watch=GoodWatch("pty:"+emu.pty);
+watch.poke(0x1C00, 0x1234);
+check("Host reopened at 9600 is heard", watch.peek(0x1C00)==0x1234);
+
+emu.stop();
+sys.exit(1 if failures else 0);
@@ -0,0 +1,2 @@
+//! Host builds don't track the git hash.
+#define GITHASH 0
@@ -0,0 +1,451 @@
+/*! \file hal.c
+  \brief Register file and clock for the host emulator.
+
+  Firmware modules built for the host reach their registers through
+  hal_reg(), by way of the macros in our msp430.h.  The trick is that
+  C gives us no hook on a plain assignment, so every register access
+  first settles the one before it:
+
+  1) If the slot no longer holds the value we presented, the firmware
+  wrote it, and the write is passed to the peripheral model.
+
+  2) Otherwise it was a read, and the peripheral is told so that
+  read-to-clear flags and auto-read bursts behave.
+
+  Write-only registers are presented as HAL_UNWRITTEN, which no byte
+  or word write can match, so even writing the same value twice is
+  noticed.  Every access costs a few cycles, so that busy loops on the
+  radio's flags let emulated time move forward.
+
+  The direct FIFO registers, RF1ATXFIFO and RF1ARXFIFO, are only
+  modeled as DMA addresses, because that is the only way the firmware
+  uses them.
+
+  The UART is modeled by usci.c in the same way as the radio.  Its
+  interrupt handler is only called if uart.c was linked in.
+
+  P1IN and P2IN are worked out at each read from the pin directions,
+  the pull resistors and whichever key is held, so keypad.c and
+  sidebutton.c scan an emulated key matrix just as they would the
+  real one.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "cc1101.h"
+#include "usci.h"
+
+//! Cycles charged for each register access.
+#define HAL_ACCESSCYCLES 4
+//! Cycles stolen from the CPU by each DMA transfer.
+#define HAL_DMACYCLES 2
+
+//! MCLK rate, which converts radio timing into CPU cycles.
+uint32_t hal_mclk=1048576;
+//! Emulated CPU cycles since hal_reset().
+uint64_t hal_cycles;
+//! Emulation aborts if hal_cycles passes this, to catch stuck loops.
+uint64_t hal_deadline;
+
+//! Cycles spent asleep in hal_sleep(), the rest being active.
+uint64_t hal_sleepcycles;
+//! Cycles for which each peripheral has been on.
+uint64_t hal_ontime[HAL_POWERCOUNT];
+//! Interrupts that woke the CPU from sleep.
+uint32_t hal_wakeups;
+//! Cycle up to which on-time has been counted.
+static uint64_t laststep;
+
+//! Count of firmware accesses to each register.
+uint32_t hal_accesses[HAL_REGCOUNT];
+//! Count of bytes moved by the DMA controller.
+uint32_t hal_dmabytes;
+
+//! Emulated address space, for firmware that turns numbers into pointers.
+uint8_t hal_memory[0x10000];
+
+//! Scan code of the key held on the keypad, as keypad.c reads it, or 0.
+uint16_t hal_keyscan;
+//! Side buttons held, as their bits of P1.
+uint8_t hal_sidebuttons;
+//! Cycle at which the keys and buttons are let go, or 0 to hold them.
+uint64_t hal_release;
+
+//! Register slots.  Plain registers live here; others are presented here.
+static volatile uint32_t slots[HAL_REGCOUNT];
+//! Full host addresses for the DMA address registers.
+static uint64_t addrs[HAL_REGCOUNT];
+//! Size of the DMA block when it was enabled, restored when it completes.
+static uint32_t dmasize;
+
+//! Register awaiting settlement, or -1.
+static int pendingreg=-1;
+//! Value that we presented for that register.
+static uint32_t pendingval;
+
+static const char * const regnames[HAL_REGCOUNT]={
+  "RF1AIFCTL1", "RF1AINSTRW", "RF1AINSTRB", "RF1AINSTR1B", "RF1ADINB",
+  "RF1ASTATB", "RF1ADOUTB", "RF1ADOUT0B", "RF1ADOUT1B", "RF1ATXFIFO",
+  "RF1ARXFIFO", "RF1AIN", "RF1AIFG", "RF1AIE", "RF1AIES", "RF1AIV",
+  "DMACTL0", "DMA0CTL", "DMA0SA", "DMA0DA", "DMA0SZ",
+  "UCA0CTL0", "UCA0CTL1", "UCA0BR0", "UCA0BR1", "UCA0MCTL", "UCA0STAT",
+  "UCA0RXBUF", "UCA0TXBUF", "UCA0IE", "UCA0IFG", "UCA0IV",
+  "LCDBMEMCTL",
+  "PMMCTL0_H", "PMMCTL0_L", "RTCSEC", "RTCMIN", "RTCHOUR",
+  "RTCPS0", "RTCPS1",
+  "LCDBCTL0", "LCDBCTL1", "LCDBVCTL", "LCDBPCTL0", "LCDBPCTL1",
+  "LCDBCPCTL", "UCSCTL0", "UCSCTL1", "UCSCTL2", "UCSCTL4", "UCSCTL5",
+  "UCSCTL6", "UCSCTL7", "SFRIFG1", "REFCTL0",
+  "ADC12CTL0", "PMAPPWD", "P1MAP5", "P1MAP6", "P1SEL", "P5SEL", "P5DIR",
+  "P1DIR", "P1OUT", "P1REN", "P1IE", "P1IES", "P1IFG", "P2DIR", "P2OUT",
+  "P2REN", "P2SEL", "P2IE", "P2IES", "P2IFG", "P2MAP7", "PMAPKEYID", "PMAPCTL", "RTCCTL01",
+  "RTCCTL2", "RTCPS0CTL", "RTCPS1CTL", "RTCIV", "RTCDOW", "RTCDAY",
+  "RTCMON", "RTCYEAR", "RTCAMIN", "RTCAHOUR", "RTCADOW", "RTCADAY",
+  "TA1CTL", "TA1CCTL0", "TA1CCR0", "SFRIE1", "SYSBSLC", "WDTCTL",
+  "P1IN", "P2IN"
+};
+
+//The radio's interrupt handler, from packet.c.
+void packet_isr(void);
+//The UART's interrupt handler, from uart.c if it was linked.
+void USCI_A0_ISR(void) __attribute__ ((weak));
+
+//! Clears the registers, the clock and the counters.
+void hal_reset(){
+  memset((void*) slots, 0, sizeof(slots));
+  memset(hal_memory, 0, sizeof(hal_memory));
+  memset(addrs, 0, sizeof(addrs));
+  memset(hal_accesses, 0, sizeof(hal_accesses));
+  hal_dmabytes=0;
+  hal_cycles=0;
+  hal_sleepcycles=0;
+  memset(hal_ontime, 0, sizeof(hal_ontime));
+  hal_wakeups=0;
+  laststep=0;
+  hal_keyscan=0;
+  hal_sidebuttons=0;
+  hal_release=0;
+  pendingreg=-1;
+  cc1101_reset();
+  usci_reset();
+}
+
+//! Level of the DMA trigger that DMACTL0 selects.
+static int hal_dmatrigger(int tsel){
+  if(tsel==DMA0TSEL__RFRXIFG)
+    return cc1101_rxready();
+  if(tsel==DMA0TSEL__RFTXIFG)
+    return cc1101_txready();
+  return 0;
+}
+
+//! Moves a byte on each edge of the DMA trigger, or on DMAREQ.
+static void hal_dmarun(){
+  static int lastlevel, pending;
+  int tsel=slots[HAL_DMACTL0]&0x1F;
+  uint32_t ctl=slots[HAL_DMA0CTL];
+  uint64_t txfifo=(uintptr_t) &slots[HAL_RF1ATXFIFO];
+  uint64_t rxfifo=(uintptr_t) &slots[HAL_RF1ARXFIFO];
+  int level=hal_dmatrigger(tsel);
+  uint8_t byte;
+
+  //Edges are ignored while the channel is disabled.
+  if(!(ctl&DMAEN)){
+    lastlevel=level;
+    pending=0;
+    return;
+  }
+  if(ctl&DMALEVEL){
+    //Only the external DMAE0 trigger may be level sensitive.
+    printf("DMALEVEL is only valid with DMAE0.\n");
+    slots[HAL_DMA0CTL]=ctl&=~DMALEVEL;
+  }
+  if(ctl&DMAREQ){
+    pending=1;
+    slots[HAL_DMA0CTL]=ctl&=~DMAREQ;
+  }
+  if(level && !lastlevel)
+    pending=1;
+  lastlevel=level;
+
+  while(slots[HAL_DMA0SZ]){
+    //Wait for the next edge.
+    if(!pending)
+      return;
+
+    if(addrs[HAL_DMA0SA]==rxfifo)
+      byte=cc1101_rxpop();
+    else
+      byte=*(uint8_t*) (uintptr_t) addrs[HAL_DMA0SA];
+    if(addrs[HAL_DMA0DA]==txfifo)
+      cc1101_txpush(byte);
+    else
+      *(uint8_t*) (uintptr_t) addrs[HAL_DMA0DA]=byte;
+
+    if((ctl&DMASRCINCR_3)==DMASRCINCR_3)
+      addrs[HAL_DMA0SA]++;
+    if((ctl&DMADSTINCR_3)==DMADSTINCR_3)
+      addrs[HAL_DMA0DA]++;
+    slots[HAL_DMA0SZ]--;
+    hal_dmabytes++;
+    hal_cycles+=HAL_DMACYCLES;
+
+    //The flag drops as the FIFO takes the byte, and comes back as an edge if it's still ready.
+    pending=lastlevel=hal_dmatrigger(tsel);
+  }
+  pending=0;
+
+  //Single transfers disable themselves when the block is done.
+  slots[HAL_DMA0SZ]=dmasize;
+  slots[HAL_DMA0CTL]=(ctl&~DMAEN)|DMAIFG;
+}
+
+//! Level of the pins of P1 or P2, from their drivers, pulls and keys.
+static uint32_t hal_portin(int reg){
+  uint32_t p1, p2, rowpin, colp2, colp1, level;
+
+  //Firmware that waits on a button mustn't wait forever.
+  if(hal_release && hal_cycles>=hal_release){
+    hal_keyscan=0;
+    hal_sidebuttons=0;
+    hal_release=0;
+  }
+
+  //Outputs read what they drive, inputs their pull or a low float.
+  p1=slots[HAL_P1OUT]&(slots[HAL_P1DIR]|slots[HAL_P1REN]);
+  p2=slots[HAL_P2OUT]&(slots[HAL_P2DIR]|slots[HAL_P2REN]);
+
+  /* A held key bridges its row, P2.3 to P2.6, to its column, which is
+     one of P2.2 to P2.0 or P1.7.  Whichever side is an output drives
+     the other.
+   */
+  if(hal_keyscan){
+    rowpin=(hal_keyscan&0xF0)>>1;
+    colp2=(hal_keyscan&0x0E)>>1;
+    colp1=(hal_keyscan&0x01) ? BIT7 : 0;
+    if(slots[HAL_P2DIR]&rowpin){
+      level=p2&rowpin;
+      colp2&=~slots[HAL_P2DIR];
+      colp1&=~slots[HAL_P1DIR];
+      p2=level ? p2|colp2 : p2&~colp2;
+      p1=level ? p1|colp1 : p1&~colp1;
+    }else if((slots[HAL_P2DIR]&colp2) || (slots[HAL_P1DIR]&colp1)){
+      level=(p2&colp2&slots[HAL_P2DIR]) || (p1&colp1&slots[HAL_P1DIR]);
+      p2=level ? p2|rowpin : p2&~rowpin;
+    }
+  }
+
+  //Side buttons short their inputs to ground.
+  p1&=~(hal_sidebuttons&~slots[HAL_P1DIR]);
+
+  return (reg==HAL_P1IN ? p1 : p2)&0xFF;
+}
+
+//! Charges the cycles since the last step to the peripherals that are on.
+static void hal_powerstep(){
+  uint64_t elapsed=hal_cycles-laststep;
+
+  laststep=hal_cycles;
+  if(slots[HAL_REFCTL0]&REFON)
+    hal_ontime[HAL_POWER_REF]+=elapsed;
+  if(slots[HAL_ADC12CTL0]&ADC12ON)
+    hal_ontime[HAL_POWER_ADC]+=elapsed;
+  if(slots[HAL_TA1CTL]&MC_3)
+    hal_ontime[HAL_POWER_BUZZER]+=elapsed;
+  if(slots[HAL_LCDBVCTL]&LCDCPEN)
+    hal_ontime[HAL_POWER_LCDCP]+=elapsed;
+}
+
+//! Brings the peripherals up to the current cycle.
+static void hal_step(){
+  if(hal_deadline && hal_cycles>hal_deadline){
+    printf("Emulation passed its deadline at cycle %llu.  Stuck loop?\n",
+           (unsigned long long) hal_cycles);
+    exit(1);
+  }
+  hal_powerstep();
+  cc1101_run(hal_cycles);
+  usci_run(hal_cycles);
+  hal_dmarun();
+}
+
+//! Cycle of the next peripheral event, or UINT64_MAX if none.
+uint64_t hal_nextevent(){
+  uint64_t radio=cc1101_nextevent(), uart=usci_nextevent();
+
+  return radio<uart ? radio : uart;
+}
+
+//! Settles any outstanding register access.
+void hal_flush(){
+  int reg=pendingreg;
+  uint32_t value;
+
+  if(reg<0)
+    return;
+  pendingreg=-1;
+  value=slots[reg];
+
+  if(reg>=HAL_RF1AFIRST && reg<=HAL_RF1ALAST){
+    if(value!=pendingval)
+      cc1101_regwrite(reg, value);
+    else
+      cc1101_regdone(reg);
+  }else if(reg>=HAL_UCA0FIRST && reg<=HAL_UCA0LAST){
+    if(value!=pendingval)
+      usci_regwrite(reg, value);
+    else
+      usci_regdone(reg);
+  }else if(reg==HAL_LCDBMEMCTL && (value&(LCDCLRM|LCDCLRBM))){
+    //Clearing the memory takes a moment, but we do it at once.
+    if(value&LCDCLRM)
+      memset((void*) &LCDM1, 0, HAL_LCDMLEN);
+    if(value&LCDCLRBM)
+      memset((void*) &LCDBM1, 0, HAL_LCDMLEN);
+    slots[reg]=value&~(LCDCLRM|LCDCLRBM);
+  }else if(reg==HAL_DMA0CTL && value!=pendingval){
+    if((value&DMAEN) && !(pendingval&DMAEN)){
+      dmasize=slots[HAL_DMA0SZ];
+      hal_dmarun();
+    }
+  }
+}
+
+//! Returns the slot of a register, after settling the previous access.
+volatile uint32_t *hal_reg(int reg){
+  hal_flush();
+  hal_cycles+=HAL_ACCESSCYCLES;
+  hal_accesses[reg]++;
+  hal_step();
+
+  if(reg>=HAL_RF1AFIRST && reg<=HAL_RF1ALAST)
+    slots[reg]=cc1101_regread(reg);
+  else if(reg>=HAL_UCA0FIRST && reg<=HAL_UCA0LAST)
+    slots[reg]=usci_regread(reg);
+  else if(reg==HAL_P1IN || reg==HAL_P2IN)
+    slots[reg]=hal_portin(reg);
+  pendingreg=reg;
+  pendingval=slots[reg];
+  return &slots[reg];
+}
+
+//! Writes a 20-bit address register.
+void __data16_write_addr(unsigned short reg, unsigned long value){
+  int i;
+
+  /* The firmware passes the register's address truncated to sixteen
+     bits, which is still unique within our small slot array.
+   */
+  hal_flush();
+  for(i=0; i<HAL_REGCOUNT; i++){
+    if((unsigned short) (uintptr_t) &slots[i]==reg){
+      addrs[i]=value;
+      hal_accesses[i]++;
+      return;
+    }
+  }
+  printf("Unknown address register %04x.\n", reg);
+  exit(1);
+}
+
+//! Advances the clock as a busy loop would, without taking interrupts.
+void hal_delay(uint32_t cycles){
+  uint64_t target=hal_cycles+cycles;
+  uint64_t next;
+
+  hal_flush();
+  while(hal_cycles<target){
+    next=hal_nextevent();
+    hal_cycles=next<target ? next : target;
+    hal_step();
+  }
+}
+
+//! Burns CPU cycles, which advances the emulated radio.
+void __delay_cycles(unsigned long cycles){
+  hal_delay(cycles);
+}
+
+//! Advances the clock as LPM3 would, taking radio and UART interrupts.
+void hal_sleep(uint32_t cycles){
+  uint64_t target=hal_cycles+cycles;
+  uint64_t next;
+
+  hal_flush();
+  for(;;){
+    hal_step();
+    if(cc1101_irq()){
+      hal_wakeups++;
+      packet_isr();
+      hal_flush();
+      continue;
+    }
+    if(USCI_A0_ISR && usci_irq()){
+      hal_wakeups++;
+      USCI_A0_ISR();
+      hal_flush();
+      continue;
+    }
+    if(hal_cycles>=target)
+      break;
+    next=hal_nextevent();
+    next=next<target ? next : target;
+    hal_sleepcycles+=next-hal_cycles;
+    hal_cycles=next;
+  }
+}
+
+//! Value of a register, without counting as an access.
+uint32_t hal_peek(int reg){
+  //A pending write is already in the slot, so nothing need be settled.
+  return slots[reg];
+}
+
+//! Total register accesses since hal_reset().
+uint32_t hal_totalaccesses(){
+  uint32_t total=0;
+  int i;
+
+  for(i=0; i<HAL_REGCOUNT; i++)
+    total+=hal_accesses[i];
+  return total;
+}
+
+//! Name of a register, for reports.
+const char *hal_regname(int reg){
+  return reg>=0 && reg<HAL_REGCOUNT ? regnames[reg] : "?";
+}
+
+//! Advances the RTC's calendar by one second.
+void hal_rtctick(){
+  static const uint8_t monthdays[]={31,28,31,30,31,30,31,31,30,31,30,31};
+  uint32_t days;
+
+  hal_flush();
+  if(++slots[HAL_RTCSEC]<60)
+    return;
+  slots[HAL_RTCSEC]=0;
+  if(++slots[HAL_RTCMIN]<60)
+    return;
+  slots[HAL_RTCMIN]=0;
+  if(++slots[HAL_RTCHOUR]<24)
+    return;
+  slots[HAL_RTCHOUR]=0;
+  slots[HAL_RTCDOW]=(slots[HAL_RTCDOW]+1)%7;
+
+  //Like the real RTC, we only know the leap years of this century.
+  if(slots[HAL_RTCMON]<1 || slots[HAL_RTCMON]>12)
+    slots[HAL_RTCMON]=1;
+  days=monthdays[slots[HAL_RTCMON]-1];
+  if(slots[HAL_RTCMON]==2 && !(slots[HAL_RTCYEAR]%4))
+    days++;
+  if(++slots[HAL_RTCDAY]<=days)
+    return;
+  slots[HAL_RTCDAY]=1;
+  if(++slots[HAL_RTCMON]<=12)
+    return;
+  slots[HAL_RTCMON]=1;
+  slots[HAL_RTCYEAR]++;
+}
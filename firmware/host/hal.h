@@ -0,0 +1,63 @@
+/*! \file hal.h
+  \brief Register file and clock for the host emulator.
+*/
+
+#include <stdint.h>
+#include "msp430.h"
+
+//! Presented in write-only slots, so that any write is noticed.
+#define HAL_UNWRITTEN 0xFFFFFFFF
+
+//! MCLK rate, which converts radio timing into CPU cycles.
+extern uint32_t hal_mclk;
+//! Emulated CPU cycles since hal_reset().
+extern uint64_t hal_cycles;
+//! Emulation aborts if hal_cycles passes this, to catch stuck loops.
+extern uint64_t hal_deadline;
+
+//! Scan code of the key held on the keypad, as keypad.c reads it, or 0.
+extern uint16_t hal_keyscan;
+//! Side buttons held, as their bits of P1.
+extern uint8_t hal_sidebuttons;
+//! Cycle at which the keys and buttons are let go, or 0 to hold them.
+extern uint64_t hal_release;
+
+//! Peripherals whose on-time is counted, for energy estimates.
+enum hal_power {
+  HAL_POWER_REF,     //REFON of REFCTL0.
+  HAL_POWER_ADC,     //ADC12ON of ADC12CTL0.
+  HAL_POWER_BUZZER,  //Timer_A1 counting, which drives the piezo.
+  HAL_POWER_LCDCP,   //LCDCPEN of LCDBVCTL, the LCD's charge pump.
+  HAL_POWERCOUNT
+};
+
+//! Cycles spent asleep in hal_sleep(), the rest being active.
+extern uint64_t hal_sleepcycles;
+//! Cycles for which each peripheral has been on.
+extern uint64_t hal_ontime[HAL_POWERCOUNT];
+//! Interrupts that woke the CPU from sleep.
+extern uint32_t hal_wakeups;
+
+//! Count of firmware accesses to each register.
+extern uint32_t hal_accesses[HAL_REGCOUNT];
+//! Count of bytes moved by the DMA controller.
+extern uint32_t hal_dmabytes;
+
+//! Clears the registers, the clock and the counters.
+void hal_reset();
+//! Settles any outstanding register access.
+void hal_flush();
+//! Advances the clock as a busy loop would, without taking interrupts.
+void hal_delay(uint32_t cycles);
+//! Advances the clock as LPM3 would, taking radio and UART interrupts.
+void hal_sleep(uint32_t cycles);
+//! Cycle of the next peripheral event, or UINT64_MAX if none.
+uint64_t hal_nextevent();
+//! Value of a register, without counting as an access.
+uint32_t hal_peek(int reg);
+//! Total register accesses since hal_reset().
+uint32_t hal_totalaccesses();
+//! Name of a register, for reports.
+const char *hal_regname(int reg);
+//! Advances the RTC's calendar by one second.
+void hal_rtctick();
@@ -0,0 +1,93 @@
+/*! \file lcdview.c
+  \brief Renders the emulated LCD as text.
+
+  The segments are read back through lcdtext.c's own tables, so a
+  string drawn with lcd_string() comes back as itself, except where
+  the seven segment font can't tell two characters apart.  Digits win
+  those ties, so an O reads back as a zero and an S as a five.
+
+  The text is the eight digits from left to right, in quotes, followed
+  by the names of any symbols that are lit.  The blink memory is shown
+  instead of the main memory while LCDDISP is set, as the glass would.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "lcdview.h"
+
+//Fonts and the segment map, from lcdtext.c.
+extern const int lcdmap[10][8];
+extern const int numfont[];
+extern const int letterfont[];
+
+//! Segment of the decimal point, which lcdtext.c calls DP.
+#define DP 0x80
+//! Segment of the middle bar, which lcdtext.c calls G.
+#define G 0x40
+
+//! Symbols drawn by lcdtext.c, as byte and bit of the LCD memory.
+static const struct {
+  const char *name;
+  int byte, bit;
+} symbols[]={
+  {"colon", 3, 0x20},
+  {"am", 0, 0x04},
+  {"pm", 1, 0x40},
+  {"mult", 4, 0x40},
+  {"minus", 6, 0x04},
+  {"plus", 7, 0x40},
+  {"divide", 0xc, 0x04},
+  {0, 0, 0}
+};
+
+//! Returns the character that a set of segments most likely shows.
+static char lcdview_char(int segments){
+  int i;
+
+  if(!segments)
+    return ' ';
+  if(segments==DP)
+    return '.';
+  if(segments==G)
+    return '-';
+
+  //K and Q need their DP, so try the letters whole first.
+  for(i=0; i<26; i++)
+    if(letterfont[i]&DP && letterfont[i]==segments)
+      return 'a'+i;
+
+  segments&=~DP;
+  for(i=0; i<10; i++)
+    if(numfont[i]==segments)
+      return '0'+i;
+  for(i=0; i<26; i++)
+    if(letterfont[i]==segments)
+      return 'a'+i;
+  return '?';
+}
+
+//! Renders the visible LCD memory as eight characters and its symbols.
+void lcdview_text(char *text){
+  volatile uint8_t *lcd=(hal_peek(HAL_LCDBMEMCTL)&LCDDISP) ? &LCDBM1 : &LCDM1;
+  int pos, bit, segments, i;
+
+  //Position 7 is the leftmost digit.
+  text[0]='"';
+  for(pos=7; pos>=0; pos--){
+    segments=0;
+    for(bit=0; bit<8; bit++)
+      if(lcd[lcdmap[pos][bit]>>8] & lcdmap[pos][bit] & 0xFF)
+        segments|=1<<bit;
+    text[8-pos]=lcdview_char(segments);
+  }
+  text[9]='"';
+  text[10]=0;
+
+  for(i=0; symbols[i].name; i++){
+    if(lcd[symbols[i].byte]&symbols[i].bit){
+      strcat(text, " ");
+      strcat(text, symbols[i].name);
+    }
+  }
+}
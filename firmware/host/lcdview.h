@@ -0,0 +1,9 @@
+/*! \file lcdview.h
+  \brief Renders the emulated LCD as text.
+*/
+
+//! Longest rendering, with room for every symbol.
+#define LCDVIEW_LEN 64
+
+//! Renders the visible LCD memory as eight characters and its symbols.
+void lcdview_text(char *text);
@@ -0,0 +1,529 @@
+/*! \file msp430.h
+  \brief Host stand-in for the CC430F6137 device header.
+
+  This header is found before the real one when building firmware
+  modules for the host emulator.  Each peripheral register becomes an
+  access through hal_reg(), which hands back a 32-bit slot.  The slot
+  is prefilled with whatever a read ought to return, and it is checked
+  at the next register access to see whether the firmware wrote to it.
+  That's enough to emulate strobes, FIFOs and read-to-clear flags
+  without changing a line of radio.c or packet.c.
+
+  Only the registers used by the emulated modules are defined here.
+  Add more as you bring more of the firmware to the host.
+*/
+
+#ifndef HOST_MSP430_H
+#define HOST_MSP430_H
+
+#include <stdint.h>
+
+#define BIT0 (0x0001)
+#define BIT1 (0x0002)
+#define BIT2 (0x0004)
+#define BIT3 (0x0008)
+#define BIT4 (0x0010)
+#define BIT5 (0x0020)
+#define BIT6 (0x0040)
+#define BIT7 (0x0080)
+#define BIT8 (0x0100)
+#define BIT9 (0x0200)
+#define BITA (0x0400)
+#define BITB (0x0800)
+#define BITC (0x1000)
+#define BITD (0x2000)
+#define BITE (0x4000)
+#define BITF (0x8000)
+
+//! Emulated registers, in the order of hal.c's tables.
+enum hal_register {
+  //Radio core interface, handled by cc1101.c.
+  HAL_RF1AIFCTL1,
+  HAL_RF1AINSTRW,
+  HAL_RF1AINSTRB,
+  HAL_RF1AINSTR1B,
+  HAL_RF1ADINB,
+  HAL_RF1ASTATB,
+  HAL_RF1ADOUTB,
+  HAL_RF1ADOUT0B,
+  HAL_RF1ADOUT1B,
+  HAL_RF1ATXFIFO,
+  HAL_RF1ARXFIFO,
+  HAL_RF1AIN,
+  HAL_RF1AIFG,
+  HAL_RF1AIE,
+  HAL_RF1AIES,
+  HAL_RF1AIV,
+
+  //DMA controller, handled by hal.c.
+  HAL_DMACTL0,
+  HAL_DMA0CTL,
+  HAL_DMA0SA,
+  HAL_DMA0DA,
+  HAL_DMA0SZ,
+
+  //USCI_A0 as a UART, handled by usci.c.
+  HAL_UCA0CTL0,
+  HAL_UCA0CTL1,
+  HAL_UCA0BR0,
+  HAL_UCA0BR1,
+  HAL_UCA0MCTL,
+  HAL_UCA0STAT,
+  HAL_UCA0RXBUF,
+  HAL_UCA0TXBUF,
+  HAL_UCA0IE,
+  HAL_UCA0IFG,
+  HAL_UCA0IV,
+
+  //LCD_B memory control, handled by hal.c.
+  HAL_LCDBMEMCTL,
+
+  //Plain memory, for modules that only need the registers to exist.
+  HAL_PMMCTL0_H,
+  HAL_PMMCTL0_L,
+  HAL_RTCSEC,
+  HAL_RTCMIN,
+  HAL_RTCHOUR,
+  HAL_RTCPS0,
+  HAL_RTCPS1,
+  HAL_LCDBCTL0,
+  HAL_LCDBCTL1,
+  HAL_LCDBVCTL,
+  HAL_LCDBPCTL0,
+  HAL_LCDBPCTL1,
+  HAL_LCDBCPCTL,
+  HAL_UCSCTL0,
+  HAL_UCSCTL1,
+  HAL_UCSCTL2,
+  HAL_UCSCTL4,
+  HAL_UCSCTL5,
+  HAL_UCSCTL6,
+  HAL_UCSCTL7,
+  HAL_SFRIFG1,
+  HAL_REFCTL0,
+  HAL_ADC12CTL0,
+  HAL_PMAPPWD,
+  HAL_P1MAP5,
+  HAL_P1MAP6,
+  HAL_P1SEL,
+  HAL_P5SEL,
+  HAL_P5DIR,
+  HAL_P1DIR,
+  HAL_P1OUT,
+  HAL_P1REN,
+  HAL_P1IE,
+  HAL_P1IES,
+  HAL_P1IFG,
+  HAL_P2DIR,
+  HAL_P2OUT,
+  HAL_P2REN,
+  HAL_P2SEL,
+  HAL_P2IE,
+  HAL_P2IES,
+  HAL_P2IFG,
+  HAL_P2MAP7,
+  HAL_PMAPKEYID,
+  HAL_PMAPCTL,
+  HAL_RTCCTL01,
+  HAL_RTCCTL2,
+  HAL_RTCPS0CTL,
+  HAL_RTCPS1CTL,
+  HAL_RTCIV,
+  HAL_RTCDOW,
+  HAL_RTCDAY,
+  HAL_RTCMON,
+  HAL_RTCYEAR,
+  HAL_RTCAMIN,
+  HAL_RTCAHOUR,
+  HAL_RTCADOW,
+  HAL_RTCADAY,
+  HAL_TA1CTL,
+  HAL_TA1CCTL0,
+  HAL_TA1CCR0,
+  HAL_SFRIE1,
+  HAL_SYSBSLC,
+  HAL_WDTCTL,
+
+  //Port inputs, computed by hal.c from the keys and the pin directions.
+  HAL_P1IN,
+  HAL_P2IN,
+
+  HAL_REGCOUNT
+};
+
+//! First and last registers that belong to the radio core.
+#define HAL_RF1AFIRST HAL_RF1AIFCTL1
+#define HAL_RF1ALAST HAL_RF1AIV
+//! First and last registers that belong to the UART.
+#define HAL_UCA0FIRST HAL_UCA0CTL0
+#define HAL_UCA0LAST HAL_UCA0IV
+
+//! Returns the slot of a register, after settling the previous access.
+volatile uint32_t *hal_reg(int reg);
+
+/* The firmware sometimes turns numbers into pointers, to reach the
+   dmesg buffer or to serve PEEK and POKE.  The host won't let us map
+   the low 64kB, so those addresses land in this array instead.  The
+   LCD memory lives here too, at its real address, so that a READ of
+   it from the host sees the same bytes as on a watch.
+ */
+extern uint8_t hal_memory[0x10000];
+#define MEMPTR(adr) ((void*) &hal_memory[(uint16_t) (adr)])
+
+#define RF1AIFCTL1  (*hal_reg(HAL_RF1AIFCTL1))
+#define RF1AINSTRW  (*hal_reg(HAL_RF1AINSTRW))
+#define RF1AINSTRB  (*hal_reg(HAL_RF1AINSTRB))
+#define RF1AINSTR1B (*hal_reg(HAL_RF1AINSTR1B))
+#define RF1ADINB    (*hal_reg(HAL_RF1ADINB))
+#define RF1ASTATB   (*hal_reg(HAL_RF1ASTATB))
+#define RF1ADOUTB   (*hal_reg(HAL_RF1ADOUTB))
+#define RF1ADOUT0B  (*hal_reg(HAL_RF1ADOUT0B))
+#define RF1ADOUT1B  (*hal_reg(HAL_RF1ADOUT1B))
+#define RF1ATXFIFO  (*hal_reg(HAL_RF1ATXFIFO))
+#define RF1ARXFIFO  (*hal_reg(HAL_RF1ARXFIFO))
+#define RF1AIN      (*hal_reg(HAL_RF1AIN))
+#define RF1AIFG     (*hal_reg(HAL_RF1AIFG))
+#define RF1AIE      (*hal_reg(HAL_RF1AIE))
+#define RF1AIES     (*hal_reg(HAL_RF1AIES))
+#define RF1AIV      (*hal_reg(HAL_RF1AIV))
+
+#define DMACTL0     (*hal_reg(HAL_DMACTL0))
+#define DMA0CTL     (*hal_reg(HAL_DMA0CTL))
+#define DMA0SA      (*hal_reg(HAL_DMA0SA))
+#define DMA0DA      (*hal_reg(HAL_DMA0DA))
+#define DMA0SZ      (*hal_reg(HAL_DMA0SZ))
+
+#define UCA0CTL0    (*hal_reg(HAL_UCA0CTL0))
+#define UCA0CTL1    (*hal_reg(HAL_UCA0CTL1))
+#define UCA0BR0     (*hal_reg(HAL_UCA0BR0))
+#define UCA0BR1     (*hal_reg(HAL_UCA0BR1))
+#define UCA0MCTL    (*hal_reg(HAL_UCA0MCTL))
+#define UCA0STAT    (*hal_reg(HAL_UCA0STAT))
+#define UCA0RXBUF   (*hal_reg(HAL_UCA0RXBUF))
+#define UCA0TXBUF   (*hal_reg(HAL_UCA0TXBUF))
+#define UCA0IE      (*hal_reg(HAL_UCA0IE))
+#define UCA0IFG     (*hal_reg(HAL_UCA0IFG))
+#define UCA0IV      (*hal_reg(HAL_UCA0IV))
+
+#define LCDBMEMCTL  (*hal_reg(HAL_LCDBMEMCTL))
+#define LCDM1       (*(volatile uint8_t*) MEMPTR(0x0A20))
+#define LCDBM1      (*(volatile uint8_t*) MEMPTR(0x0A40))
+//! Bytes of LCD memory, LCDM1 to LCDM20.
+#define HAL_LCDMLEN 20
+
+#define PMMCTL0_H   (*hal_reg(HAL_PMMCTL0_H))
+#define PMMCTL0_L   (*hal_reg(HAL_PMMCTL0_L))
+#define RTCSEC      (*hal_reg(HAL_RTCSEC))
+#define RTCMIN      (*hal_reg(HAL_RTCMIN))
+#define RTCHOUR     (*hal_reg(HAL_RTCHOUR))
+#define RTCPS0      (*hal_reg(HAL_RTCPS0))
+#define RTCPS1      (*hal_reg(HAL_RTCPS1))
+#define LCDBCTL0    (*hal_reg(HAL_LCDBCTL0))
+#define LCDBCTL1    (*hal_reg(HAL_LCDBCTL1))
+#define LCDBVCTL    (*hal_reg(HAL_LCDBVCTL))
+#define LCDBPCTL0   (*hal_reg(HAL_LCDBPCTL0))
+#define LCDBPCTL1   (*hal_reg(HAL_LCDBPCTL1))
+#define LCDBCPCTL   (*hal_reg(HAL_LCDBCPCTL))
+#define UCSCTL0     (*hal_reg(HAL_UCSCTL0))
+#define UCSCTL1     (*hal_reg(HAL_UCSCTL1))
+#define UCSCTL2     (*hal_reg(HAL_UCSCTL2))
+#define UCSCTL4     (*hal_reg(HAL_UCSCTL4))
+#define UCSCTL5     (*hal_reg(HAL_UCSCTL5))
+#define UCSCTL6     (*hal_reg(HAL_UCSCTL6))
+#define UCSCTL7     (*hal_reg(HAL_UCSCTL7))
+#define SFRIFG1     (*hal_reg(HAL_SFRIFG1))
+#define REFCTL0     (*hal_reg(HAL_REFCTL0))
+#define ADC12CTL0   (*hal_reg(HAL_ADC12CTL0))
+#define PMAPPWD     (*hal_reg(HAL_PMAPPWD))
+#define P1MAP5      (*hal_reg(HAL_P1MAP5))
+#define P1MAP6      (*hal_reg(HAL_P1MAP6))
+#define P1SEL       (*hal_reg(HAL_P1SEL))
+#define P5SEL       (*hal_reg(HAL_P5SEL))
+#define P5DIR       (*hal_reg(HAL_P5DIR))
+#define P1DIR       (*hal_reg(HAL_P1DIR))
+#define P1OUT       (*hal_reg(HAL_P1OUT))
+#define P1REN       (*hal_reg(HAL_P1REN))
+#define P1IE        (*hal_reg(HAL_P1IE))
+#define P1IES       (*hal_reg(HAL_P1IES))
+#define P1IFG       (*hal_reg(HAL_P1IFG))
+#define P2DIR       (*hal_reg(HAL_P2DIR))
+#define P2OUT       (*hal_reg(HAL_P2OUT))
+#define P2REN       (*hal_reg(HAL_P2REN))
+#define P2SEL       (*hal_reg(HAL_P2SEL))
+#define P2IE        (*hal_reg(HAL_P2IE))
+#define P2IES       (*hal_reg(HAL_P2IES))
+#define P2IFG       (*hal_reg(HAL_P2IFG))
+#define P2MAP7      (*hal_reg(HAL_P2MAP7))
+#define PMAPKEYID   (*hal_reg(HAL_PMAPKEYID))
+#define PMAPCTL     (*hal_reg(HAL_PMAPCTL))
+#define RTCCTL01    (*hal_reg(HAL_RTCCTL01))
+#define RTCCTL2     (*hal_reg(HAL_RTCCTL2))
+#define RTCPS0CTL   (*hal_reg(HAL_RTCPS0CTL))
+#define RTCPS1CTL   (*hal_reg(HAL_RTCPS1CTL))
+#define RTCIV       (*hal_reg(HAL_RTCIV))
+#define RTCDOW      (*hal_reg(HAL_RTCDOW))
+#define RTCDAY      (*hal_reg(HAL_RTCDAY))
+#define RTCMON      (*hal_reg(HAL_RTCMON))
+#define RTCYEAR     (*hal_reg(HAL_RTCYEAR))
+#define RTCAMIN     (*hal_reg(HAL_RTCAMIN))
+#define RTCAHOUR    (*hal_reg(HAL_RTCAHOUR))
+#define RTCADOW     (*hal_reg(HAL_RTCADOW))
+#define RTCADAY     (*hal_reg(HAL_RTCADAY))
+#define TA1CTL      (*hal_reg(HAL_TA1CTL))
+#define TA1CCTL0    (*hal_reg(HAL_TA1CCTL0))
+#define TA1CCR0     (*hal_reg(HAL_TA1CCR0))
+#define SFRIE1      (*hal_reg(HAL_SFRIE1))
+#define SYSBSLC     (*hal_reg(HAL_SYSBSLC))
+#define WDTCTL      (*hal_reg(HAL_WDTCTL))
+#define P1IN        (*hal_reg(HAL_P1IN))
+#define P2IN        (*hal_reg(HAL_P2IN))
+
+//RF1AIFCTL1 flags.
+#define RFRXIFG     (0x0001)
+#define RFTXIFG     (0x0002)
+#define RFERRIFG    (0x0008)
+#define RFINSTRIFG  (0x0010)
+#define RFDINIFG    (0x0020)
+#define RFSTATIFG   (0x0040)
+#define RFDOUTIFG   (0x0080)
+
+//Radio core instructions.
+#define RF_SNGLREGRD    0x80
+#define RF_SNGLREGWR    0x00
+#define RF_REGRD        0xC0
+#define RF_REGWR        0x40
+#define RF_STATREGRD    0xC0
+#define RF_SNGLPATABRD  (RF_SNGLREGRD+PATABLE)
+#define RF_SNGLPATABWR  (RF_SNGLREGWR+PATABLE)
+#define RF_PATABRD      (RF_REGRD+PATABLE)
+#define RF_PATABWR      (RF_REGWR+PATABLE)
+#define RF_SNGLRXRD     (RF_SNGLREGRD+RXFIFO)
+#define RF_SNGLTXWR     (RF_SNGLREGWR+TXFIFO)
+#define RF_RXFIFORD     (RF_REGRD+RXFIFO)
+#define RF_TXFIFOWR     (RF_REGWR+TXFIFO)
+
+//Radio core strobes.
+#define RF_SRES         0x30
+#define RF_SFSTXON      0x31
+#define RF_SXOFF        0x32
+#define RF_SCAL         0x33
+#define RF_SRX          0x34
+#define RF_STX          0x35
+#define RF_SIDLE        0x36
+#define RF_SWOR         0x38
+#define RF_SPWD         0x39
+#define RF_SFRX         0x3A
+#define RF_SFTX         0x3B
+#define RF_SWORRST      0x3C
+#define RF_SNOP         0x3D
+
+//Radio core configuration registers.
+#define IOCFG2          0x00
+#define IOCFG1          0x01
+#define IOCFG0          0x02
+#define FIFOTHR         0x03
+#define SYNC1           0x04
+#define SYNC0           0x05
+#define PKTLEN          0x06
+#define PKTCTRL1        0x07
+#define PKTCTRL0        0x08
+#define ADDR            0x09
+#define CHANNR          0x0A
+#define FSCTRL1         0x0B
+#define FSCTRL0         0x0C
+#define FREQ2           0x0D
+#define FREQ1           0x0E
+#define FREQ0           0x0F
+#define MDMCFG4         0x10
+#define MDMCFG3         0x11
+#define MDMCFG2         0x12
+#define MDMCFG1         0x13
+#define MDMCFG0         0x14
+#define DEVIATN         0x15
+#define MCSM2           0x16
+#define MCSM1           0x17
+#define MCSM0           0x18
+#define FOCCFG          0x19
+#define BSCFG           0x1A
+#define AGCCTRL2        0x1B
+#define AGCCTRL1        0x1C
+#define AGCCTRL0        0x1D
+#define WOREVT1         0x1E
+#define WOREVT0         0x1F
+#define WORCTRL         0x20
+#define FREND1          0x21
+#define FREND0          0x22
+#define FSCAL3          0x23
+#define FSCAL2          0x24
+#define FSCAL1          0x25
+#define FSCAL0          0x26
+#define FSTEST          0x29
+#define PTEST           0x2A
+#define AGCTEST         0x2B
+#define TEST2           0x2C
+#define TEST1           0x2D
+#define TEST0           0x2E
+
+//Radio core status registers.
+#define PARTNUM         0x30
+#define VERSION         0x31
+#define FREQEST         0x32
+#define LQI             0x33
+#define RSSI            0x34
+#define MARCSTATE       0x35
+#define WORTIME1        0x36
+#define WORTIME0        0x37
+#define PKTSTATUS       0x38
+#define VCO_VC_DAC      0x39
+#define TXBYTES         0x3A
+#define RXBYTES         0x3B
+
+#define PATABLE         0x3E
+#define TXFIFO          0x3F
+#define RXFIFO          0x3F
+
+//DMA controller.
+#define DMA0TSEL__RFRXIFG (14)
+#define DMA0TSEL__RFTXIFG (15)
+#define DMADT_0         (0x0000)
+#define DMADSTINCR_0    (0x0000)
+#define DMADSTINCR_3    (0x0C00)
+#define DMASRCINCR_0    (0x0000)
+#define DMASRCINCR_3    (0x0300)
+#define DMADSTBYTE      (0x0080)
+#define DMASRCBYTE      (0x0040)
+#define DMASBDB         (DMASRCBYTE|DMADSTBYTE)
+#define DMALEVEL        (0x0020)
+#define DMAEN           (0x0010)
+#define DMAIFG          (0x0008)
+#define DMAREQ          (0x0001)
+#define DMAIE           (0x0004)
+
+//Power management.
+#define PMMHPMRE_L      (0x0080)
+
+//USCI_A0 in UART mode.
+#define UCSWRST         (0x01)
+#define UCRXEIE         (0x20)
+#define UCSSEL0         (0x40)
+#define UCSSEL1         (0x80)
+#define UCSSEL_1        (0x40)
+#define UCSSEL_2        (0x80)
+#define UCBRS_1         (0x02)
+#define UCBRS_2         (0x04)
+#define UCBRS_3         (0x06)
+#define UCBRS_5         (0x0A)
+#define UCBRF_0         (0x00)
+#define UCBUSY          (0x01)
+#define UCRXERR         (0x04)
+#define UCOE            (0x20)
+#define UCFE            (0x40)
+#define UCRXIE          (0x0001)
+#define UCTXIE          (0x0002)
+#define UCRXIFG         (0x0001)
+#define UCTXIFG         (0x0002)
+#define PM_UCA0RXD      (5)
+#define PM_UCA0TXD      (6)
+
+//LCD_B.
+#define LCDON           (0x0001)
+#define LCDSON          (0x0004)
+#define LCD3MUX         (0x0010)
+#define LCDSSEL         (0x0080)
+#define LCDPRE0         (0x0100)
+#define LCDDIV0         (0x0800)
+#define LCDDIV1         (0x1000)
+#define LCDDIV2         (0x2000)
+#define LCDDIV3         (0x4000)
+#define LCDDIV4         (0x8000)
+#define LCD2B           (0x0001)
+#define LCDCPEN         (0x0008)
+#define VLCD_2_60       (0x0200)
+#define VLCD_3_44       (0x1E00)
+#define LCDDISP         (0x0001)
+#define LCDCLRM         (0x0002)
+#define LCDCLRBM        (0x0004)
+
+//Unified clock system.
+#define SELM_0          (0x0000)
+#define SELM_3          (0x0003)
+#define SELM_7          (0x0007)
+#define DIVM_0          (0x0000)
+#define DIVM_1          (0x0001)
+#define DIVM_2          (0x0002)
+#define DIVM_7          (0x0007)
+#define DCORSEL_3       (0x0030)
+#define FLLD_2          (0x2000)
+#define SELS0           (0x0010)
+#define SELS1           (0x0020)
+#define SELS2           (0x0040)
+#define SELS_0          (0x0000)
+#define SELS_3          (0x0030)
+#define SELS_4          (0x0040)
+#define SELA_0          (0x0000)
+#define SELA_1          (0x0100)
+#define XCAP_1          (0x0004)
+#define XT1DRIVE_3      (0x00C0)
+#define DCOFFG          (0x0001)
+#define XT1LFOFFG       (0x0002)
+#define OFIFG           (0x0002)
+
+//Reference and ADC12, only so that lcd.c can test whether they're on.
+#define REFON           (0x0001)
+#define ADC12ON         (0x0010)
+
+//Real-time clock, calendar mode.
+#define RTCMODE         (0x2000)
+#define RTCSSEL_2       (0x0800)
+#define RTCTEV_0        (0x0000)
+#define RTCTEVIE        (0x0040)
+#define RTCAIE          (0x0020)
+#define RT0PSDIV_2      (0x1000)
+#define RT1SSEL_2       (0x8000)
+#define RT1PSDIV_3      (0x1800)
+
+//Timer_A1, which drives the buzzer.
+#define TACLR           (0x0004)
+#define TASSEL__SMCLK   (0x0200)
+#define MC__STOP        (0x0000)
+#define MC__UP          (0x0010)
+#define MC_3            (0x0030)
+#define CCIE            (0x0010)
+#define OUTMOD_4        (0x0080)
+#define PM_TA1CCR0A     (14)
+
+//Special function registers.
+#define WDTIE           (0x0001)
+#define WDTPW           (0x5A00)
+#define WDTHOLD         (0x0080)
+#define WDT_ADLY_250    (0x5A3D)
+#define VMAIE           (0x0008)
+#define ACCVIE          (0x0020)
+
+//Interrupt vectors.  The attribute becomes harmless on the host.
+#define CC1101_VECTOR   (54)
+#define USCI_A0_VECTOR  (57)
+#define RTC_VECTOR      (41)
+#define PORT2_VECTOR    (42)
+#define PORT1_VECTOR    (47)
+#define interrupt(vector) used
+
+/* Some firmware headers, like adc10.h, declare registers in the style
+   of the device header.  They are only declarations here, so they
+   needn't exist unless an emulated module uses them.
+ */
+#define sfrb(x,x_) extern volatile uint8_t x
+#define sfrw(x,x_) extern volatile uint16_t x
+#define sfra(x,x_) extern volatile uint32_t x
+
+//! Writes a 20-bit address register.
+void __data16_write_addr(unsigned short reg, unsigned long value);
+//! Burns CPU cycles, which advances the emulated radio.
+void __delay_cycles(unsigned long cycles);
+#define __bic_SR_register_on_exit(bits)
+#define __bis_SR_register(bits)
+#define __bic_SR_register(bits)
+#define SCG0            (0x0040)
+#define LPM3_bits       (0x00D0)
+
+#endif
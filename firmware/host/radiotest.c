@@ -0,0 +1,287 @@
+/*! \file radiotest.c
+  \brief Host tests of radio.c, packet.c and the radio applets.
+
+  These run the real firmware modules against the radio model of
+  cc1101.c, so that the drivers can be regression tested without a
+  watch on the bench.  Each test also prints the register traffic that
+  it caused, which is a fair proxy for the cycles and power that the
+  same code will cost on the CC430.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "hal.h"
+#include "cc1101.h"
+#include "api.h"
+#include "apps/pager.h"
+#include "apps/ook.h"
+
+//! One second of MCLK.
+#define SECOND (hal_mclk)
+
+/* Stand-ins for the modules that aren't emulated yet.  The LCD is
+   kept as text, leftmost digit first, so tests can check what the
+   applet drew.
+ */
+
+static char lcdtext[9]="        ";
+
+void lcd_zero(){
+  strcpy(lcdtext, "        ");
+}
+void lcd_string(const char *str){
+  int i=7;
+  while(i>=0 && *str)
+    lcdtext[7-i--]=*str++;
+}
+void lcd_digit(int pos, int digit){
+  lcdtext[7-pos]="0123456789abcdef"[digit&0xF];
+}
+void lcd_hex(long num){
+  snprintf(lcdtext, sizeof(lcdtext), "%8lx", num);
+}
+void lcd_number(long num){
+  snprintf(lcdtext, sizeof(lcdtext), "%8ld", num);
+}
+void setcolon(int on){
+}
+void app_cleartimer(){
+}
+void app_next(){
+}
+int power_setvcore(int level){
+  return 1;
+}
+
+//! Applet callbacks, as apps.c would dispatch them.
+static void (*packetrx)(uint8_t *packet, int len);
+static void (*packettx)();
+static int packettxcount;
+
+void app_packetrx(uint8_t *packet, int len){
+  if(packetrx)
+    packetrx(packet, len);
+}
+void app_packettx(){
+  packettxcount++;
+  if(packettx)
+    packettx();
+}
+
+//! Resets the emulator for a new test.
+static void begin(){
+  hal_reset();
+  hal_deadline=60*SECOND;
+  packetrx=0;
+  packettx=0;
+  packettxcount=0;
+  lcd_zero();
+}
+
+//! Prints the register traffic of a test.
+static void report(const char *name){
+  int i;
+
+  printf("%-8s %6u accesses, %4u instructions, %3u strobes, "
+         "%5u FIFO bytes, %6.3f s\n",
+         name, hal_totalaccesses(), cc1101_instructions, cc1101_strobes,
+         cc1101_fifobytes, (double) hal_cycles/SECOND);
+  for(i=0; i<HAL_REGCOUNT; i++)
+    if(hal_accesses[i])
+      printf("\t%-12s %6u\n", hal_regname(i), hal_accesses[i]);
+}
+
+//! Radio bringup, registers and the PATABLE.
+static void test_init(){
+  uint8_t table[2];
+
+  begin();
+  radio_init();
+  assert(has_radio);
+  assert(radio_getstate()==2); //XOFF
+
+  radio_on();
+  assert(radio_getstate()==1); //IDLE
+  radio_writesettings(0);
+  assert(cc1101_peek(MDMCFG4)==0xCA);
+  assert(cc1101_peek(FIFOTHR)==0x47);
+  //Registers missing from the table keep their reset values.
+  assert(cc1101_peek(PKTLEN)==0xFF);
+
+  radio_setfreq(433920000);
+  assert(radio_getfreq()>433919000 && radio_getfreq()<433921000);
+
+  radio_writepower(0x25);
+  radio_readburstreg(PATABLE, table, 2);
+  assert(table[0]==0x00 && table[1]==0x25);
+
+  radio_off();
+  report("init");
+}
+
+//! Settings for transmit tests, OOK without preamble or sync.
+static const uint8_t txsettings[]={
+  MDMCFG4, 0x86,
+  MDMCFG3, 0xD9,
+  MDMCFG2, 0x30,
+  PKTCTRL0, 0x00,
+  FIFOTHR, 0x47,
+  MCSM1, 0x30,
+  0, 0
+};
+
+//! A frame repeated back-to-back, then the radio falls idle.
+static void test_repeat(){
+  uint8_t frame[16];
+  int i;
+
+  begin();
+  for(i=0; i<16; i++)
+    frame[i]=0x80|i;
+  radio_on();
+  radio_writesettings(txsettings);
+  radio_writereg(PKTLEN, sizeof(frame));
+
+  assert(packet_txrepeat(frame, sizeof(frame), 5));
+  hal_sleep(SECOND);
+
+  assert(cc1101_sentcount==5);
+  for(i=0; i<5; i++){
+    assert(cc1101_sent[i].length==sizeof(frame));
+    assert(!memcmp(cc1101_sent[i].data, frame, sizeof(frame)));
+    assert(!cc1101_sent[i].underflow);
+    if(i)
+      assert(cc1101_sent[i].start==cc1101_sent[i-1].end);
+  }
+  assert(packettxcount==1);
+  assert(radio_getstate()==1);
+  assert(cc1101_peek(MCSM1)==0x30);
+
+  radio_off();
+  report("repeat");
+}
+
+//! A frame longer than the FIFO must be refilled as it drains.
+static void test_long(){
+  uint8_t frame[200];
+  int i;
+
+  begin();
+  for(i=0; i<sizeof(frame); i++)
+    frame[i]=i*7;
+  radio_on();
+  radio_writesettings(txsettings);
+  radio_writereg(PKTLEN, sizeof(frame));
+
+  packet_tx(frame, sizeof(frame));
+  hal_sleep(2*SECOND);
+
+  assert(cc1101_sentcount==1);
+  assert(cc1101_sent[0].length==sizeof(frame));
+  assert(!cc1101_sent[0].underflow);
+  assert(!memcmp(cc1101_sent[0].data, frame, sizeof(frame)));
+  assert(packettxcount==1);
+
+  radio_off();
+  report("long");
+}
+
+//! The OOK applet repeats a button's frame for as long as it is held.
+static void test_ook(){
+  static const char * const buttons[]={ OOKBUTTONS };
+  int i, count;
+
+  begin();
+  packettx=ook_packettx;
+  ook_init();
+  ook_keypress('0');
+  hal_sleep(SECOND);
+  count=cc1101_sentcount;
+  ook_keypress(0);
+
+  //Several frames, all identical and without gaps.
+  assert(count>2 && count<=CC1101_LOGLEN);
+  for(i=0; i<count; i++){
+    assert(cc1101_sent[i].length==16);
+    assert(!memcmp(cc1101_sent[i].data, buttons[0]+2, 16));
+    assert(!cc1101_sent[i].underflow);
+    if(i)
+      assert(cc1101_sent[i].start==cc1101_sent[i-1].end);
+  }
+  report("ook");
+}
+
+//! The pager wakes on the preamble and decodes a page from the air.
+static void test_pager(){
+  const struct pocsag_message *msg;
+  int i;
+
+  begin();
+  packetrx=pager_packetrx;
+  pager_init();
+  //Take every message, whatever RIC might be in config.h.
+  pocsag_filter=0;
+
+  for(i=0; i<12; i++){
+    if(i==1)
+      assert(cc1101_airfile("pocsag.rx")==1);
+    pager_draw();
+    hal_sleep(SECOND/4);
+  }
+  assert(!cc1101_airbusy());
+
+  msg=pocsag_getmessage(0);
+  assert(msg);
+  assert(msg->id==147092);
+  assert(!strcmp(msg->text, "KK4VCZ: Jo"));
+  assert(!strcmp(lcdtext, "KK4VCZ: "));
+
+  pager_exit();
+  report("pager");
+}
+
+//! Receives a page that spans two batches, draining the FIFO mid-packet.
+static void test_pagerbatches(){
+  const struct pocsag_message *msg;
+  uint16_t count;
+  int i;
+
+  begin();
+  packetrx=pager_packetrx;
+  pager_init();
+  pocsag_filter=0;
+  count=pocsag_messagecount;
+
+  for(i=0; i<16; i++){
+    if(i==1)
+      assert(cc1101_airfile("pocsag2.rx")==1);
+    pager_draw();
+    hal_sleep(SECOND/4);
+  }
+  assert(!cc1101_airbusy());
+
+  //Exactly one message, not one per batch.
+  assert(pocsag_messagecount==count+1);
+  msg=pocsag_getmessage(0);
+  assert(msg->id==147095);
+  assert(!strcmp(msg->text, "KK4VCZ: Jo"));
+
+  pager_exit();
+  report("pager batches");
+}
+
+//! Unix command-line tool for testing.
+int main(){
+  //Unbuffered, so that firmware messages come before any failed assert.
+  setvbuf(stdout, 0, _IONBF, 0);
+
+  test_init();
+  test_repeat();
+  test_long();
+  test_ook();
+  test_pager();
+  test_pagerbatches();
+  printf("All radio tests passed.\n");
+  return 0;
+}
@@ -0,0 +1,304 @@
+/*! \file usci.c
+  \brief Software model of USCI_A0 as a UART.
+
+  This models just enough of the USCI to run uart.c on a workstation:
+
+  1) UCSWRST, which clears the interrupt enables and leaves only
+  UCTXIFG set, as the hardware does.
+
+  2) A transmit buffer in front of a shift register, so that UCTXIFG
+  comes back as soon as a byte moves to the shifter, and UCBUSY holds
+  until the last bit is out.
+
+  3) A receive buffer that the host fills one byte per character time.
+  A byte that arrives before the last was read sets UCOE and replaces
+  it, just as a slow interrupt handler would lose it on a watch.
+
+  4) UCA0IV, whose read clears the flag that it reports.
+
+  The character time is ten bits at the rate from UCA0BR0, UCA0BR1 and
+  UCBRS, with the clock taken from UCSSEL and, for SMCLK, from the
+  SELS bits of UCSCTL4.  A host that has set its own rate with
+  usci_hostbaud() garbles every byte sent more than 5% away from ours.
+  Those set UCFE and UCRXERR if UCRXEIE is set, and are otherwise
+  dropped without UCRXIFG, as the hardware does.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "usci.h"
+#include "ucs.h"
+
+//! Bytes that may wait in each direction.
+#define QUEUELEN 8192
+
+//! Bytes received, bytes sent and bytes lost to overruns.
+uint32_t usci_rxbytes, usci_txbytes, usci_overruns;
+//! Bytes that arrived with framing errors.
+uint32_t usci_framingerrors;
+//! Host's baud rate, or zero if it always agrees with ours.
+static uint32_t hostbaud;
+
+//! Control and rate registers, kept as the firmware wrote them.
+static uint8_t ctl1, br0, br1, mctl, ie;
+//! Flags, status and the receive buffer.
+static uint8_t ifg, stat, rxbuf;
+//! Flag reported by the last read of UCA0IV.
+static uint8_t ivflag;
+
+//! Byte waiting in UCA0TXBUF, and the byte in the shifter, or -1.
+static int txbuf=-1, shifting=-1;
+//! Cycle at which the shifter finishes.
+static uint64_t shiftend;
+
+//! Bytes from the host, not yet received.
+static uint8_t rxqueue[QUEUELEN];
+static int rxhead, rxtail;
+//! Cycle at which the next byte from the host is received.
+static uint64_t nextrx;
+
+//! Bytes sent to the host, not yet taken.
+static uint8_t txqueue[QUEUELEN];
+static int txhead, txtail;
+
+//! Resets the UART and empties its queues.
+void usci_reset(){
+  ctl1=UCSWRST;
+  br0=br1=mctl=ie=0;
+  ifg=UCTXIFG;
+  stat=rxbuf=ivflag=0;
+  txbuf=shifting=-1;
+  rxhead=rxtail=txhead=txtail=0;
+  nextrx=0;
+  usci_rxbytes=usci_txbytes=usci_overruns=usci_framingerrors=0;
+  hostbaud=0;
+}
+
+//! Source clock of the UART in Hz.
+static uint32_t usci_clock(){
+  if((ctl1&(UCSSEL0|UCSSEL1))==UCSSEL_2
+     && (hal_peek(HAL_UCSCTL4)&(SELS0|SELS1|SELS2))==SELS_4)
+    return UCS_SMCLKDCO;
+  return 32768;
+}
+
+//! Baud rate, as configured by the firmware.
+uint32_t usci_baud(){
+  uint32_t eighths=8*(br0|(br1<<8)) + ((mctl>>1)&7);
+
+  return eighths ? 8*usci_clock()/eighths : 0;
+}
+
+//! Sets the host's baud rate, or zero for one that always agrees.
+void usci_hostbaud(uint32_t baud){
+  hostbaud=baud;
+}
+
+//! Does the host's rate differ from ours enough to garble a byte?
+static int usci_garbled(){
+  uint32_t baud=usci_baud();
+
+  if(!hostbaud || !baud)
+    return 0;
+  return 20*(hostbaud>baud ? hostbaud-baud : baud-hostbaud) > baud;
+}
+
+//! CPU cycles of one character, with a start and stop bit.
+static uint64_t usci_chartime(){
+  uint32_t baud=usci_baud();
+
+  return baud ? 10*(uint64_t) hal_mclk/baud : 1;
+}
+
+//! Queues bytes from the host, which arrive one at a time at the baud rate.
+void usci_rxqueue(const uint8_t *bytes, int length){
+  int i;
+
+  //The first byte of a burst needs its own character time on the line.
+  if(rxhead==rxtail && nextrx<hal_cycles+usci_chartime())
+    nextrx=hal_cycles+usci_chartime();
+  for(i=0; i<length; i++){
+    if(((rxhead+1)%QUEUELEN)==rxtail){
+      printf("UART model dropped %d bytes from the host.\n", length-i);
+      return;
+    }
+    rxqueue[rxhead]=bytes[i];
+    rxhead=(rxhead+1)%QUEUELEN;
+  }
+}
+
+//! Copies out bytes that the firmware has finished sending.  Returns the count.
+int usci_txtake(uint8_t *bytes, int length){
+  int count=0;
+
+  while(count<length && txtail!=txhead){
+    bytes[count++]=txqueue[txtail];
+    txtail=(txtail+1)%QUEUELEN;
+  }
+  return count;
+}
+
+//! Returns non-zero while bytes are on the line in either direction.
+int usci_busy(){
+  return shifting>=0 || rxhead!=rxtail;
+}
+
+//! Moves a byte into the shifter.
+static void usci_shift(int byte){
+  shifting=byte;
+  shiftend=hal_cycles+usci_chartime();
+  ifg|=UCTXIFG;
+}
+
+//! Value presented to the firmware when it touches a register.
+uint32_t usci_regread(int reg){
+  switch(reg){
+  case HAL_UCA0CTL1:
+    return ctl1;
+  case HAL_UCA0BR0:
+    return br0;
+  case HAL_UCA0BR1:
+    return br1;
+  case HAL_UCA0MCTL:
+    return mctl;
+  case HAL_UCA0STAT:
+    return stat | (shifting>=0 ? UCBUSY : 0);
+  case HAL_UCA0RXBUF:
+    return rxbuf;
+  case HAL_UCA0TXBUF:
+    return HAL_UNWRITTEN;
+  case HAL_UCA0IE:
+    return ie;
+  case HAL_UCA0IFG:
+    return ifg;
+  case HAL_UCA0IV:
+    //Receive has the higher priority.
+    if(ifg&ie&UCRXIFG){
+      ivflag=UCRXIFG;
+      return 2;
+    }else if(ifg&ie&UCTXIFG){
+      ivflag=UCTXIFG;
+      return 4;
+    }
+    ivflag=0;
+    return 0;
+  default:
+    return 0;
+  }
+}
+
+//! Called when the firmware has written a register.
+void usci_regwrite(int reg, uint32_t value){
+  switch(reg){
+  case HAL_UCA0CTL1:
+    ctl1=value;
+    if(ctl1&UCSWRST){
+      //Bytes in flight are lost, as on the real thing.
+      ie=0;
+      ifg=UCTXIFG;
+      stat=0;
+      txbuf=shifting=-1;
+    }
+    break;
+  case HAL_UCA0BR0:
+    br0=value;
+    break;
+  case HAL_UCA0BR1:
+    br1=value;
+    break;
+  case HAL_UCA0MCTL:
+    mctl=value;
+    break;
+  case HAL_UCA0STAT:
+    stat=value&~UCBUSY;
+    break;
+  case HAL_UCA0TXBUF:
+    if(ctl1&UCSWRST)
+      break;
+    ifg&=~UCTXIFG;
+    if(shifting<0)
+      usci_shift(value&0xFF);
+    else
+      txbuf=value&0xFF;
+    break;
+  case HAL_UCA0IE:
+    ie=value;
+    break;
+  case HAL_UCA0IFG:
+    //Software may set flags to request an interrupt.
+    ifg=value;
+    break;
+  }
+}
+
+//! Called when the firmware has read a register.
+void usci_regdone(int reg){
+  switch(reg){
+  case HAL_UCA0RXBUF:
+    ifg&=~UCRXIFG;
+    stat&=~(UCOE|UCFE|UCRXERR);
+    break;
+  case HAL_UCA0IV:
+    ifg&=~ivflag;
+    break;
+  }
+}
+
+//! Runs the UART up to the given cycle.
+void usci_run(uint64_t now){
+  for(;;){
+    if(shifting>=0 && shiftend<=now
+       && (rxhead==rxtail || shiftend<=nextrx)){
+      //Last bit of a byte is out.
+      txqueue[txhead]=shifting;
+      txhead=(txhead+1)%QUEUELEN;
+      usci_txbytes++;
+      shifting=-1;
+      if(txbuf>=0){
+        shifting=txbuf;
+        txbuf=-1;
+        shiftend+=usci_chartime();
+        ifg|=UCTXIFG;
+      }
+    }else if(rxhead!=rxtail && nextrx<=now && !(ctl1&UCSWRST)){
+      //A byte from the host is received.
+      uint8_t byte=rxqueue[rxtail];
+      rxtail=(rxtail+1)%QUEUELEN;
+      usci_rxbytes++;
+      nextrx+=usci_chartime();
+
+      if(usci_garbled()){
+        usci_framingerrors++;
+        //Without UCRXEIE, the USCI drops a character with errors.
+        if(!(ctl1&UCRXEIE))
+          continue;
+        stat|=UCFE|UCRXERR;
+      }
+      if(ifg&UCRXIFG){
+        stat|=UCOE;
+        usci_overruns++;
+      }
+      rxbuf=byte;
+      ifg|=UCRXIFG;
+    }else{
+      break;
+    }
+  }
+}
+
+//! Cycle of the next scheduled event, or UINT64_MAX if none.
+uint64_t usci_nextevent(){
+  uint64_t next=UINT64_MAX;
+
+  if(shifting>=0)
+    next=shiftend;
+  if(rxhead!=rxtail && !(ctl1&UCSWRST) && nextrx<next)
+    next=nextrx;
+  return next;
+}
+
+//! Returns non-zero if an enabled interrupt is pending.
+int usci_irq(){
+  return !(ctl1&UCSWRST) && (ifg&ie&(UCRXIFG|UCTXIFG));
+}
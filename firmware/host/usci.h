@@ -0,0 +1,38 @@
+/*! \file usci.h
+  \brief Software model of USCI_A0 as a UART.
+*/
+
+#include <stdint.h>
+
+//! Bytes received, bytes sent and bytes lost to overruns.
+extern uint32_t usci_rxbytes, usci_txbytes, usci_overruns;
+//! Bytes that arrived with framing errors.
+extern uint32_t usci_framingerrors;
+
+//! Resets the UART and empties its queues.
+void usci_reset();
+//! Queues bytes from the host, which arrive one at a time at the baud rate.
+void usci_rxqueue(const uint8_t *bytes, int length);
+//! Copies out bytes that the firmware has finished sending.  Returns the count.
+int usci_txtake(uint8_t *bytes, int length);
+//! Returns non-zero while bytes are on the line in either direction.
+int usci_busy();
+//! Baud rate, as configured by the firmware.
+uint32_t usci_baud();
+//! Sets the host's baud rate, or zero for one that always agrees.
+void usci_hostbaud(uint32_t baud);
+
+/* These are called by hal.c, and ought not be needed by tests. */
+
+//! Value presented to the firmware when it touches a register.
+uint32_t usci_regread(int reg);
+//! Called when the firmware has written a register.
+void usci_regwrite(int reg, uint32_t value);
+//! Called when the firmware has read a register.
+void usci_regdone(int reg);
+//! Runs the UART up to the given cycle.
+void usci_run(uint64_t now);
+//! Cycle of the next scheduled event, or UINT64_MAX if none.
+uint64_t usci_nextevent();
+//! Returns non-zero if an enabled interrupt is pending.
+int usci_irq();
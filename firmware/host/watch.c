@@ -0,0 +1,217 @@
+/*! \file watch.c
+  \brief The watch's main.c, as far as the host can run it.
+
+  main.c itself can't be linked, because it owns main() and the POST
+  pokes at hardware that isn't emulated.  Instead, this boots the
+  modules in the same order and runs each quarter-second frame the way
+  its WDT interrupt would, so that watchemu and appsim drive the real
+  applet table.
+
+  It also holds the stand-ins for modules that aren't emulated yet.
+  printf() is renamed to emu_printf() when the Makefile builds the
+  firmware, so that its messages land in dmesg as they would on a
+  watch.  Our own printf() is left alone, and goes to the console.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "hal.h"
+#include "watch.h"
+#include "api.h"
+#include "applist.h"
+#include "rng.h"
+
+//! Set to echo dmesg to stderr.
+int watch_echo=1;
+//! Firmware function calls, counted by -finstrument-functions.
+uint32_t watch_calls;
+//! Battery voltage that the ADC reads, in hundredths of a volt.
+unsigned int watch_vcc=300;
+
+//The keypad's interrupt handler and key table, from keypad.c.
+void PORT2_ISR(void);
+//The RTC's interrupt handler, from rtc.c.
+void RTC_ISR(void);
+//The side buttons' interrupt handler, from sidebutton.c.
+void PORT1_ISR(void);
+extern const unsigned int keymap[];
+
+//! Called on entry to every instrumented firmware function.
+void __attribute__ ((no_instrument_function))
+__cyg_profile_func_enter(void *func, void *caller){
+  watch_calls++;
+}
+//! Called on exit from every instrumented firmware function.
+void __attribute__ ((no_instrument_function))
+__cyg_profile_func_exit(void *func, void *caller){
+}
+
+int emu_printf(const char *fmt, ...){
+  char buf[256];
+  va_list ap;
+  int i, len;
+
+  va_start(ap, fmt);
+  len=vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if(len>=(int) sizeof(buf))
+    len=sizeof(buf)-1;
+  for(i=0; i<len; i++)
+    putchar(buf[i]);
+  if(watch_echo)
+    fputs(buf, stderr);
+  return len;
+}
+volatile uint16_t ADC10CTL0;
+int power_setvcore(int level){
+  return 1;
+}
+int power_ishigh(){
+  return 0;
+}
+unsigned int true_rand(){
+  return rand()&0xFFFF;
+}
+long l2bcd(long num){
+  long bcd=0;
+  int shift;
+
+  for(shift=0; num; shift+=4, num/=10)
+    bcd|=(num%10)<<shift;
+  return bcd;
+}
+//! The battery, a fresh CR2016 unless a script says otherwise.
+unsigned int adc_getvcc(){
+  //A conversion keeps the ADC12 on for about 29 of its 5MHz clocks.
+  ADC12CTL0=ADC12ON;
+  __delay_cycles(8);
+  ADC12CTL0=0;
+  return watch_vcc;
+}
+void ref_on(){
+  REFCTL0|=REFON;
+}
+void ref_off(){
+  REFCTL0&=~REFON;
+}
+//! The self-test of main.c, which clock.c calls and which can't fail here.
+int post(){
+  return 0;
+}
+
+/* rtcasm.S works around an RTC erratum by careful alignment, which
+   the register model doesn't need.
+ */
+int SetRTCYEAR(int year){ return RTCYEAR=year; }
+int SetRTCMON(int month){ return RTCMON=month; }
+int SetRTCDAY(int day){ return RTCDAY=day; }
+int SetRTCDOW(int dow){ return RTCDOW=dow; }
+int SetRTCHOUR(int hour){ return RTCHOUR=hour; }
+int SetRTCMIN(int min){ return RTCMIN=min; }
+int SetRTCSEC(int sec){ return RTCSEC=sec; }
+
+//! Boots the firmware modules in the order of main.c, at a given time.
+void watch_boot(const struct tm *tm){
+  hal_reset();
+  hal_deadline=0;
+  watch_vcc=300;
+  RTCHOUR=tm->tm_hour;
+  RTCMIN=tm->tm_min;
+  RTCSEC=tm->tm_sec;
+  RTCDAY=tm->tm_mday;
+  RTCMON=tm->tm_mon+1;
+  RTCYEAR=tm->tm_year+1900;
+  rtc_setdow();
+
+  dmesg_init();
+  lcd_init();
+  lcd_zero();
+  buzz_init();
+  codeplug_init();
+  radio_init();
+  app_init();
+  key_init();
+  sidebutton_init();
+  uart_init();
+  app_frames(1);
+  emu_printf("Booted.\n");
+}
+
+//! One quarter-second frame, as the WDT interrupt of main.c would run it.
+void watch_frame(){
+  static int quarter=0, latch=0, oldsec=-1;
+
+  //The RTC ticks every fourth frame.
+  if(++quarter==4){
+    quarter=0;
+    hal_rtctick();
+
+    //The minute event wakes the RTC's handler before the frame.
+    if(!RTCSEC){
+      hal_wakeups++;
+      RTCIV=4;
+      RTC_ISR();
+    }
+  }
+
+  //Without its interrupt, the WDT doesn't wake us at all.
+  if(!(SFRIE1&WDTIE))
+    return;
+  hal_wakeups++;
+
+  //As in main.c, the monitor has the CPU to itself.
+  if(uartactive)
+    return;
+
+  //Mode moves to the next applet, or home if held for four seconds.
+  if(sidebutton_mode()){
+    if(!(latch++))
+      app_next();
+    if(latch>16)
+      app_forcehome();
+  }else{
+    latch=0;
+  }
+
+  //The clock is only drawn when the second changes.
+  if(applet->draw!=clock_draw || oldsec!=RTCSEC){
+    oldsec=RTCSEC;
+    lcd_predraw();
+    app_draw(0);
+    lcd_postdraw();
+  }
+}
+
+//! Presses the side buttons of a mask, letting go of the others.
+void watch_sidebuttons(uint8_t buttons){
+  uint8_t edges=buttons&~hal_sidebuttons&P1IE&P1IES;
+
+  hal_sidebuttons=buttons;
+
+  //A falling edge on an armed pin wakes Port 1's interrupt.
+  if(edges){
+    P1IFG|=edges;
+    hal_wakeups++;
+    PORT1_ISR();
+  }
+}
+
+//! Presses a key by its character, or releases it with zero.
+void watch_key(char ch){
+  int i;
+
+  hal_keyscan=0;
+  for(i=0; ch && keymap[i]; i++)
+    if((keymap[i]&0xFF)==(unsigned char) ch)
+      hal_keyscan=keymap[i]>>8;
+  if(ch && !hal_keyscan){
+    printf("No key for '%c'.\n", ch);
+    exit(1);
+  }
+
+  //The edge on a row pin wakes the keypad's interrupt.
+  hal_wakeups++;
+  PORT2_ISR();
+}
@@ -0,0 +1,21 @@
+/*! \file watch.h
+  \brief The watch's main.c, as far as the host can run it.
+*/
+
+#include <time.h>
+
+//! Set to echo dmesg to stderr.
+extern int watch_echo;
+//! Firmware function calls, counted by -finstrument-functions.
+extern uint32_t watch_calls;
+//! Battery voltage that the ADC reads, in hundredths of a volt.
+extern unsigned int watch_vcc;
+
+//! Boots the firmware modules in the order of main.c, at a given time.
+void watch_boot(const struct tm *tm);
+//! One quarter-second frame, as the WDT interrupt of main.c would run it.
+void watch_frame();
+//! Presses the side buttons of a mask, letting go of the others.
+void watch_sidebuttons(uint8_t buttons);
+//! Presses a key by its character, or releases it with zero.
+void watch_key(char ch);
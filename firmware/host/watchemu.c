@@ -0,0 +1,205 @@
+/*! \file watchemu.c
+  \brief GoodWatch emulator on a pseudo-terminal.
+
+  This runs the real monitor and applets against the register models
+  of hal.c, usci.c and cc1101.c, booted and clocked by watch.c, with
+  the UART wired to a pseudo-terminal.  Its name is printed on
+  the first line of output, and bin/goodwatch.py can open it as
+  pty:/dev/pts/N, so that the host client and the monitor can be
+  tested without a watch on /dev/ttyUSB0.
+
+  Emulated time is paced to the wall clock by default, so that each
+  byte takes as long as it would at the watch's baud rate and host
+  throughput can be measured.  With -f, the emulator runs flat out
+  while the UART is busy and only waits on the clock when idle.
+
+  The host's baud rate is read from the pseudo-terminal's settings,
+  which begin at 9600, and bytes sent at a rate other than the
+  watch's arrive with framing errors.
+
+  Usage: watchemu [-f] [-q] [-l] [-a air.rx] [-s seconds]
+
+  -f runs fast, -q keeps dmesg off the console, -l prints the LCD as
+  text whenever it changes, -a plays a cc1101_airfile() to the radio,
+  and -s exits after that many emulated seconds.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <sys/select.h>
+#include "hal.h"
+#include "cc1101.h"
+#include "usci.h"
+#include "lcdview.h"
+#include "watch.h"
+#include "api.h"
+
+//! Slave side of the pseudo-terminal, whose settings the host changes.
+static int slave;
+
+//! Opens a pseudo-terminal, returning its master and printing its name.
+static int openpty(){
+  struct termios tio;
+  int master;
+
+  master=posix_openpt(O_RDWR|O_NOCTTY);
+  if(master<0 || grantpt(master) || unlockpt(master)){
+    perror("posix_openpt");
+    exit(1);
+  }
+
+  /* We hold the slave open ourselves, so that the master doesn't
+     return EIO between clients.  It is raw, so that bytes pass
+     through unchanged.
+   */
+  slave=open(ptsname(master), O_RDWR|O_NOCTTY);
+  if(slave<0){
+    perror("ptsname");
+    exit(1);
+  }
+  tcgetattr(slave, &tio);
+  cfmakeraw(&tio);
+  cfsetspeed(&tio, B9600);
+  tcsetattr(slave, TCSANOW, &tio);
+
+  fcntl(master, F_SETFL, O_NONBLOCK);
+  printf("%s\n", ptsname(master));
+  return master;
+}
+
+//! Host's baud rate from the slave's settings, or zero if unknown.
+static uint32_t hostbaud(){
+  static const struct {
+    speed_t speed;
+    uint32_t baud;
+  } speeds[]={
+    {B9600, 9600}, {B19200, 19200}, {B38400, 38400},
+    {B57600, 57600}, {B115200, 115200}
+  };
+  struct termios tio;
+  unsigned int i;
+
+  if(tcgetattr(slave, &tio))
+    return 0;
+  for(i=0; i<sizeof(speeds)/sizeof(speeds[0]); i++)
+    if(cfgetospeed(&tio)==speeds[i].speed)
+      return speeds[i].baud;
+  return 0;
+}
+
+//! Seconds of wall clock time.
+static double wallclock(){
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+//! Unix command-line tool for emulating a watch.
+int main(int argc, char **argv){
+  int fast=0, showlcd=0, opt, master, n;
+  double seconds=0, offset, wait;
+  uint64_t quarter, nexttick, next, target;
+  char lcd[LCDVIEW_LEN], lastlcd[LCDVIEW_LEN]="";
+  uint8_t buf[1024];
+  struct timeval tv;
+  time_t now=time(0);
+  fd_set fds;
+
+  while((opt=getopt(argc, argv, "fqla:s:"))!=-1){
+    switch(opt){
+    case 'f': fast=1; break;
+    case 'q': watch_echo=0; break;
+    case 'l': showlcd=1; break;
+    case 'a':
+      if(cc1101_airfile(optarg)<0){
+        fprintf(stderr, "Can't read %s.\n", optarg);
+        return 1;
+      }
+      break;
+    case 's': seconds=atof(optarg); break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [-f] [-q] [-l] [-a air.rx] [-s seconds]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  //Messages from the emulator itself go to stdout, unbuffered.
+  setvbuf(stdout, 0, _IONBF, 0);
+  watch_boot(localtime(&now));
+  master=openpty();
+
+  quarter=hal_mclk/4;
+  nexttick=hal_cycles+quarter;
+  //Wall clock time at which the emulated clock was zero.
+  offset=wallclock();
+
+  for(;;){
+    /* Wait for the host until the next thing that the watch would do,
+       in wall clock time.  A fast emulator doesn't wait while the
+       UART is busy.
+     */
+    next=hal_nextevent();
+    if(next>nexttick)
+      next=nexttick;
+    wait=(double) next/hal_mclk+offset-wallclock();
+    if(fast && usci_busy())
+      wait=0;
+    FD_ZERO(&fds);
+    FD_SET(master, &fds);
+    tv.tv_sec=wait>0 ? (long) wait : 0;
+    tv.tv_usec=wait>0 ? (long) ((wait-tv.tv_sec)*1e6) : 0;
+    if(select(master+1, &fds, 0, 0, &tv)>0){
+      n=read(master, buf, sizeof(buf));
+      if(n>0){
+        usci_hostbaud(hostbaud());
+        usci_rxqueue(buf, n);
+      }
+    }
+
+    //Catch the emulated clock up to the wall, or to the next event.
+    if(fast && usci_busy()){
+      target=usci_nextevent();
+      //Keep the wall clock in step, so we don't race when idle.
+      offset=wallclock()-(double) target/hal_mclk;
+    }else{
+      target=(wallclock()-offset)*hal_mclk;
+    }
+    if(target>nexttick)
+      target=nexttick;
+    if(target>hal_cycles)
+      hal_sleep(target-hal_cycles);
+    if(hal_cycles>=nexttick){
+      watch_frame();
+      nexttick+=quarter;
+    }
+
+    //Replies go back to the host as they finish.
+    while((n=usci_txtake(buf, sizeof(buf)))>0)
+      if(write(master, buf, n)!=n)
+        fprintf(stderr, "Lost %d bytes to the host.\n", n);
+
+    if(showlcd){
+      lcdview_text(lcd);
+      if(strcmp(lcd, lastlcd)){
+        printf("lcd %s\n", lcd);
+        strcpy(lastlcd, lcd);
+      }
+    }
+
+    if(seconds && hal_cycles>=seconds*hal_mclk){
+      printf("%u bytes in, %u out, %u overruns, %u framing errors at %u baud.\n",
+             usci_rxbytes, usci_txbytes, usci_overruns, usci_framingerrors,
+             usci_baud());
+      return 0;
+    }
+  }
+}
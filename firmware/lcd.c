@@ -19,9 +19,19 @@ volatile unsigned char *lcdbm=&LCDBM1;
 //! While non-zero, this blinks a useless LCD segment to indicate CPU load.
 int flickermode=0;
 
+//! Polls of LCDCLRM before lcd_zero() gives up on it.
+#define LCDCLRMTRIES 1000
+
 //! Clears the LCD memory and blink memory.
 void lcd_zero(){
+  int i;
+
   LCDBMEMCTL|=LCDCLRM;
+  /* The bit clears itself when the memory is clear, and not before.
+     Simulators that don't model it would leave it set forever, so we
+     give up after a while.
+   */
+  for(i=0; i<LCDCLRMTRIES && (LCDBMEMCTL&LCDCLRM); i++);
 }
 
 //! Initialize the LCD memory and populate it with sample text.
@@ -68,6 +78,14 @@ void lcd_init() {
   }
 }
 
+//! Sets the charge pump to its highest contrast, or its weakest to save power.
+void lcd_contrast(int high){
+  //The bias settings are only safe to change with the LCD off.
+  LCDBCTL0 &= ~LCDON;
+  LCDBVCTL = LCDCPEN | (high ? VLCD_3_44 : VLCD_2_60) | LCD2B;
+  LCDBCTL0 |= LCDON;
+}
+
 //! Moved the LCD memory to the blink memory, then displays the backup.
 void lcd_predraw(){
   //Switch to the backup of the previous frame.
@@ -85,7 +103,8 @@ void lcd_postdraw(){
     if(UCSCTL7&2){
       setdivide(1);   //Div indicates a crystal fault.
       printf("Clock fault, attempting repair.\n");
-      ucs_init();
+      //Only the crystal is repaired, leaving the FLL and MCLK alone.
+      ucs_xt1();
       
       if(UCSCTL7&2){
 	printf("Didn't work.\n");
@@ -17,6 +17,8 @@ extern volatile unsigned char *lcdbm;
 extern void lcd_init();
 //! Zero all pixels of the display.
 extern void lcd_zero();
+//! Sets the charge pump to its highest contrast, or its weakest to save power.
+extern void lcd_contrast(int high);
 //! Call this before drawing the application.
 extern void lcd_predraw();
 //! Call this after drawing the application.
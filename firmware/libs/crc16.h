@@ -0,0 +1,9 @@
+/*! \file crc16.h
+  \brief CCITT CRC-16, as used by the BSL and our monitor.
+*/
+
+//! Adds one byte to a running CRC.
+uint16_t crc16_update(uint16_t crc, uint8_t byte);
+
+//! CRC of a whole buffer, starting from 0xFFFF.
+uint16_t crc16(const uint8_t *buffer, uint16_t length);
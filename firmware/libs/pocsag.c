@@ -3,8 +3,13 @@
   
   This is a bare bones parser for POCSAG intended to run inside of the
   CC430F6137 and CC430F6147 chips from Texas Instruments, which
-  contain a CC1101 radio core.  Sadly it does not support error
-  correction or even the parity check.
+  contain a CC1101 radio core.
+
+  Codewords are protected by a BCH(31,21) code and an even parity
+  bit.  pocsag_correct() fixes up to two bit errors with a 1kB ROM
+  table from syndrome to errored bit, and the parity bit then rejects
+  three-bit errors rather than accepting a miscorrection.  Call it on
+  every word before pocsag_handleword().
   
   If you define STANDALONE, this will compile as a text case in Unix.
   I miss my big endian machines, but not so much as to keep this
@@ -24,6 +29,140 @@
 uint32_t pocsag_lastid;
 char pocsag_buffer[MAXPAGELEN];
 
+/* These tables are generated by bin/pocsag-bchtable.py.  Codeword
+   bit n is bit n+1 of the word, as bit 0 is the parity bit.
+ */
+
+//! Syndrome of a single bit error at each position.
+static const uint16_t pocsag_bchsyndromes[31]={
+  0x001, 0x002, 0x004, 0x008, 0x010, 0x020, 0x040, 0x080,
+  0x100, 0x200, 0x369, 0x1bb, 0x376, 0x185, 0x30a, 0x17d,
+  0x2fa, 0x29d, 0x253, 0x3cf, 0x0f7, 0x1ee, 0x3dc, 0x0d1,
+  0x1a2, 0x344, 0x1e1, 0x3c2, 0x0ed, 0x1da, 0x3b4,
+};
+
+//! Lowest errored bit for each syndrome, 0xFF if uncorrectable.
+static const uint8_t pocsag_bchtable[1024]={
+  0xff,0x00,0x01,0x00,0x02,0x00,0x01,0xff,0x03,0x00,0x01,0xff,0x02,0x13,0xff,0x15,
+  0x04,0x00,0x01,0x13,0x02,0xff,0xff,0xff,0x03,0x0b,0x14,0xff,0xff,0xff,0x16,0x0a,
+  0x05,0x00,0x01,0xff,0x02,0xff,0x14,0x0d,0x03,0xff,0xff,0xff,0xff,0x0a,0xff,0xff,
+  0x04,0xff,0x0c,0xff,0x15,0xff,0xff,0xff,0xff,0xff,0xff,0x1a,0x17,0xff,0x0b,0xff,
+  0x06,0x00,0x01,0x18,0x02,0xff,0xff,0xff,0x03,0xff,0xff,0xff,0x15,0xff,0x0e,0xff,
+  0x04,0x07,0xff,0x09,0xff,0x0b,0xff,0xff,0xff,0xff,0x0b,0xff,0xff,0xff,0xff,0x0d,
+  0x05,0x0b,0xff,0x0a,0x0d,0xff,0xff,0x10,0x16,0xff,0xff,0x0d,0xff,0x07,0xff,0xff,
+  0xff,0xff,0xff,0xff,0xff,0xff,0x1b,0x07,0x18,0xff,0xff,0x13,0x0c,0x08,0xff,0xff,
+  0x07,0x00,0x01,0xff,0x02,0x08,0x19,0xff,0x03,0xff,0xff,0x13,0xff,0xff,0xff,0xff,
+  0x04,0x06,0xff,0x0f,0xff,0xff,0xff,0xff,0x16,0xff,0xff,0xff,0x0f,0x09,0xff,0xff,
+  0x05,0xff,0x08,0xff,0xff,0xff,0x0a,0x0f,0xff,0x10,0x0c,0x0a,0xff,0x06,0xff,0xff,
+  0xff,0xff,0xff,0xff,0x0c,0x0a,0xff,0x06,0xff,0x0c,0xff,0x08,0xff,0xff,0x0e,0xff,
+  0x06,0x04,0x0c,0xff,0xff,0x0e,0x0b,0xff,0x0e,0xff,0xff,0xff,0xff,0x05,0x11,0xff,
+  0x00,0x17,0xff,0x01,0xff,0x02,0x0e,0x05,0xff,0x03,0x08,0xff,0xff,0x0a,0xff,0x0f,
+  0xff,0x08,0xff,0xff,0xff,0x03,0xff,0x04,0xff,0x02,0xff,0xff,0x00,0x1c,0x08,0x01,
+  0x19,0x05,0xff,0x02,0xff,0x01,0x00,0x14,0x0d,0xff,0x09,0xff,0xff,0x04,0xff,0x03,
+  0x08,0x00,0x01,0x15,0x02,0x07,0xff,0xff,0x03,0xff,0x09,0x17,0x1a,0xff,0xff,0xff,
+  0x04,0xff,0xff,0xff,0xff,0xff,0x14,0x12,0xff,0x14,0xff,0xff,0xff,0xff,0xff,0xff,
+  0x05,0xff,0x07,0xff,0xff,0x0c,0x10,0xff,0xff,0x11,0xff,0xff,0xff,0x14,0xff,0xff,
+  0x17,0xff,0xff,0xff,0xff,0x10,0xff,0x1c,0x10,0xff,0x0a,0x07,0xff,0x06,0xff,0x15,
+  0x06,0x11,0xff,0xff,0x09,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x0b,0xff,0x10,0x18,
+  0xff,0xff,0x11,0xff,0x0d,0x14,0x0b,0xff,0xff,0x0e,0x07,0xff,0xff,0x05,0xff,0x11,
+  0xff,0x07,0xff,0xff,0xff,0xff,0xff,0xff,0x0d,0x09,0x0b,0xff,0xff,0x04,0x07,0xff,
+  0xff,0xff,0x0d,0x17,0xff,0x03,0x09,0xff,0xff,0x02,0xff,0xff,0x00,0x0f,0xff,0x01,
+  0x07,0x02,0x05,0xff,0x00,0x0d,0xff,0x01,0xff,0xff,0x0f,0xff,0x0c,0x03,0xff,0x12,
+  0x0f,0x12,0xff,0x0a,0xff,0x04,0xff,0x0e,0xff,0xff,0x06,0x05,0x12,0xff,0xff,0xff,
+  0x01,0x06,0x18,0x00,0xff,0x05,0x02,0xff,0xff,0xff,0x03,0x04,0x0f,0xff,0x06,0xff,
+  0xff,0xff,0x04,0x03,0x09,0xff,0xff,0xff,0xff,0x01,0x00,0x0b,0xff,0xff,0x10,0x02,
+  0xff,0x05,0x09,0xff,0xff,0x06,0xff,0xff,0xff,0xff,0x04,0xff,0xff,0xff,0x05,0x09,
+  0xff,0x08,0x03,0xff,0xff,0xff,0xff,0xff,0x01,0x11,0x1d,0x00,0x09,0xff,0x02,0xff,
+  0x00,0x1a,0x06,0x01,0xff,0x02,0x03,0x12,0xff,0x03,0x02,0x0c,0x01,0x08,0x15,0x00,
+  0x0e,0x04,0xff,0xff,0x0a,0xff,0xff,0x08,0xff,0xff,0x05,0x06,0xff,0x07,0x04,0xff,
+  0x09,0x00,0x01,0xff,0x02,0xff,0x16,0xff,0x03,0xff,0x08,0x0c,0xff,0x10,0xff,0x0b,
+  0x04,0xff,0xff,0x06,0x0a,0x13,0x18,0x10,0x1b,0xff,0xff,0xff,0xff,0x07,0xff,0xff,
+  0x05,0x13,0xff,0x1a,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x10,0x15,0xff,0x13,0xff,
+  0xff,0x0d,0x15,0xff,0xff,0xff,0xff,0xff,0xff,0x0f,0xff,0xff,0xff,0x16,0xff,0xff,
+  0x06,0xff,0xff,0x04,0x08,0xff,0xff,0x0d,0xff,0xff,0x0d,0xff,0x11,0xff,0xff,0xff,
+  0xff,0x01,0x00,0x12,0xff,0x1a,0xff,0x02,0xff,0x0d,0x15,0x03,0xff,0xff,0xff,0xff,
+  0x18,0xff,0xff,0xff,0xff,0xff,0xff,0x0b,0xff,0x08,0x11,0xff,0xff,0x13,0x1d,0xff,
+  0x11,0xff,0xff,0x05,0x0b,0xff,0x08,0x0e,0xff,0x0b,0x07,0xff,0xff,0xff,0x16,0xff,
+  0x07,0xff,0x12,0xff,0xff,0xff,0xff,0x0a,0x0a,0xff,0xff,0xff,0xff,0x04,0xff,0x0d,
+  0xff,0xff,0xff,0xff,0xff,0x03,0xff,0x0c,0x0c,0x02,0xff,0xff,0x00,0x11,0x19,0x01,
+  0xff,0x0f,0xff,0xff,0x12,0x19,0xff,0xff,0x0e,0xff,0x15,0xff,0x0c,0xff,0xff,0xff,
+  0xff,0x0b,0x0f,0x0a,0x08,0xff,0xff,0xff,0xff,0xff,0x06,0xff,0xff,0x05,0x12,0x0f,
+  0xff,0x0d,0x08,0xff,0xff,0xff,0xff,0xff,0xff,0x0f,0xff,0x0a,0xff,0x0b,0xff,0x08,
+  0x0e,0x09,0x0a,0x07,0x0c,0xff,0xff,0xff,0xff,0xff,0x05,0xff,0x08,0x06,0xff,0xff,
+  0xff,0xff,0xff,0xff,0x0e,0xff,0x18,0xff,0xff,0xff,0x04,0x0e,0x0a,0x09,0xff,0xff,
+  0xff,0xff,0x03,0x0c,0xff,0xff,0xff,0x09,0x01,0xff,0x10,0x00,0xff,0xff,0x02,0x0b,
+  0x08,0xff,0x03,0xff,0x06,0xff,0xff,0xff,0x01,0xff,0x0e,0x00,0xff,0x16,0x02,0xff,
+  0xff,0xff,0xff,0x17,0x10,0xff,0xff,0xff,0x0d,0xff,0x04,0x10,0xff,0xff,0x13,0xff,
+  0x10,0xff,0x13,0xff,0xff,0xff,0x0b,0xff,0xff,0x06,0x05,0x14,0xff,0xff,0x0f,0x1b,
+  0xff,0x16,0xff,0xff,0x07,0x14,0x06,0xff,0x13,0xff,0xff,0xff,0xff,0xff,0xff,0x11,
+  0x02,0x0b,0x07,0x14,0x19,0x00,0x01,0x11,0xff,0x05,0x06,0xff,0x03,0xff,0xff,0x07,
+  0xff,0xff,0xff,0x08,0x04,0xff,0x05,0xff,0x10,0x1c,0xff,0xff,0x07,0xff,0xff,0xff,
+  0xff,0x03,0xff,0xff,0x05,0x17,0x04,0xff,0x00,0x0a,0xff,0x01,0xff,0x02,0xff,0xff,
+  0xff,0xff,0x02,0x11,0x01,0xff,0x0c,0x00,0xff,0x04,0xff,0xff,0x11,0x09,0x03,0x0d,
+  0xff,0x0c,0x06,0xff,0x0a,0x09,0xff,0x0f,0xff,0x12,0x07,0xff,0xff,0xff,0xff,0x06,
+  0xff,0xff,0xff,0xff,0x05,0x17,0xff,0xff,0xff,0xff,0xff,0x0c,0x06,0x08,0x0a,0xff,
+  0xff,0xff,0x09,0xff,0x04,0xff,0xff,0x0c,0xff,0x19,0xff,0xff,0xff,0xff,0xff,0xff,
+  0x02,0xff,0x12,0x14,0x1e,0x00,0x01,0xff,0x0a,0xff,0xff,0x09,0x03,0x12,0xff,0xff,
+  0x01,0xff,0x1b,0x00,0x07,0xff,0x02,0x03,0xff,0xff,0x03,0x02,0x04,0x01,0x00,0x13,
+  0xff,0xff,0x04,0xff,0x03,0xff,0x0d,0xff,0x02,0xff,0x09,0x0e,0x16,0x00,0x01,0x04,
+  0x0f,0x09,0x05,0xff,0xff,0xff,0xff,0x0e,0x0b,0x07,0xff,0xff,0xff,0xff,0x09,0x05,
+  0xff,0x12,0xff,0xff,0x06,0xff,0x07,0xff,0xff,0xff,0x08,0xff,0x05,0x0e,0xff,0xff,
+};
+
+//! Computes the BCH(31,21) syndrome of a word, ignoring parity.
+static uint16_t pocsag_syndrome(uint32_t word){
+  /* Long division by the generator, one bit at a time.  We shift the
+     generator rather than the dividend by variable amounts, because
+     the MSP430 has no barrel shifter.
+   */
+  uint32_t codeword=word>>1;
+  uint32_t generator=0x769UL<<20;
+  uint32_t top=1UL<<30;
+  int i;
+
+  for(i=0; i<21; i++){
+    if(codeword&top)
+      codeword^=generator;
+    generator>>=1;
+    top>>=1;
+  }
+  return codeword;
+}
+
+//! Corrects up to two bit errors in a word, returning IDLE if it can't.
+uint32_t pocsag_correct(uint32_t word){
+  uint16_t syndrome=pocsag_syndrome(word);
+  uint8_t bit;
+  int fixes=0;
+
+  //A non-zero syndrome gives us the lowest bit in error.
+  if(syndrome){
+    bit=pocsag_bchtable[syndrome];
+    if(bit==0xFF)
+      return POCSAG_IDLE;
+    word^=2UL<<bit;
+    fixes++;
+
+    //Whatever remains must be a second single-bit error.
+    syndrome^=pocsag_bchsyndromes[bit];
+    if(syndrome){
+      word^=2UL<<pocsag_bchtable[syndrome];
+      fixes++;
+    }
+  }
+
+  /* Bad parity after two fixes means at least three errors.
+     Otherwise it's the parity bit itself that is damaged.
+   */
+  if(__builtin_parityl(word)){
+    if(fixes==2)
+      return POCSAG_IDLE;
+    word^=1;
+  }
+  
+  return word;
+}
+
 //! Count of words within the batch, roughly twice the frame count.
 static int wordcount=0;
 //! Count of bits in the current byte.
@@ -33,9 +172,85 @@ static char newchar=0;
 //! Character index.
 static int bytecount=0;
 
+//! Mode of the message being assembled, carried across batches.
+static uint8_t msgmode=POCSAG_MODE_NONE;
+//! Function bits of the message being assembled.
+static uint8_t msgfunction;
+
+//! Timestamp for messages that complete from now on.
+static uint32_t msgtime;
+//! Ring of completed messages, newest at msghead.
+static struct pocsag_message msgstore[POCSAG_STORELEN];
+//! Index of the newest completed message.
+static int msghead=POCSAG_STORELEN-1;
+
+//! Count of messages completed since boot.
+uint16_t pocsag_messagecount=0;
+//! If non-zero, only messages to this RIC are stored.
+uint32_t pocsag_filter=0;
+
+/* Numeric digits are sent as four bits, least significant first, so
+   this table is indexed by the nybble exactly as it arrives.
+ */
+static const char pocsag_numerics[16]="084 2*6)195-3U7(";
+
 void pocsag_newbatch(){
+  /* Only the word count restarts.  A message that is still being
+     assembled continues into the new batch.
+   */
   wordcount=0;
-  memset(pocsag_buffer,0x00,MAXPAGELEN);
+}
+
+//! Sets the timestamp recorded on messages that complete from now on.
+void pocsag_settime(uint32_t time){
+  msgtime=time;
+}
+
+//! Returns non-zero if a message is still being assembled.
+int pocsag_inmessage(){
+  return msgmode!=POCSAG_MODE_NONE;
+}
+
+//! Completes the message being assembled, if any, into the store.
+void pocsag_endmessage(){
+  struct pocsag_message *msg;
+  
+  if(msgmode==POCSAG_MODE_NONE)
+    return;
+
+  if(!pocsag_filter || pocsag_filter==pocsag_lastid){
+    if(++msghead==POCSAG_STORELEN)
+      msghead=0;
+    msg=&msgstore[msghead];
+    msg->id=pocsag_lastid;
+    msg->time=msgtime;
+    msg->function=msgfunction;
+    msg->mode=msgmode;
+    memcpy(msg->text, pocsag_buffer, MAXPAGELEN);
+    pocsag_messagecount++;
+  }
+  
+  msgmode=POCSAG_MODE_NONE;
+}
+
+//! Returns a stored message, zero being the newest, or NULL.
+const struct pocsag_message *pocsag_getmessage(int age){
+  int i;
+  
+  if(age<0 || age>=POCSAG_STORELEN || age>=pocsag_messagecount)
+    return 0;
+  i=msghead-age;
+  if(i<0)
+    i+=POCSAG_STORELEN;
+  return &msgstore[i];
+}
+
+//! Local function to append a character, truncating long messages.
+static void pocsag_append(char c){
+  if(bytecount<MAXPAGELEN-1){
+    pocsag_buffer[bytecount++]=c;
+    pocsag_buffer[bytecount]=0;
+  }
 }
 
 //! Local function to handle alphanumeric data payloads.
@@ -61,11 +276,7 @@ static void pocsag_handledataword(uint32_t word){
     //the right order.
     if(bitcount==7){
       //Record the character.
-      pocsag_buffer[bytecount++]=newchar;
-      pocsag_buffer[bytecount]=0;
-      //Safety first.
-      if(bytecount>MAXPAGELEN-1)
-        bytecount=0;
+      pocsag_append(newchar);
       //Clear our counts to start again.
       bitcount=0;
       newchar=0;
@@ -73,26 +284,54 @@ static void pocsag_handledataword(uint32_t word){
   }
 }
 
-void pocsag_handleword(uint32_t word){
+//! Local function to handle numeric data payloads.
+static void pocsag_handlenumericword(uint32_t word){
+  //Twenty bits of this word, as five digits.
+  uint32_t bits=((word&0x7FFFFFFF)>>11);
+  int i;
 
+  for(i=16; i>=0; i-=4)
+    pocsag_append(pocsag_numerics[(bits>>i)&0xF]);
+}
+
+void pocsag_handleword(uint32_t word){
+  /* Every path through here takes a fixed number of steps, so that
+     this is safe to call for each codeword from the RX handler.
+   */
   
-  if(word==0x7a89c197){         //IDLE
-    /* Just ignore idle frames, but don't yet return because we need
-       to count them.
+  if(word==POCSAG_IDLE){        //IDLE
+    /* Idle frames end any message, but we don't yet return because
+       we need to count them.
      */
+    pocsag_endmessage();
   }else if(word&0x80000000){    //DATA
-    pocsag_handledataword(word);
+    if(msgmode==POCSAG_MODE_NUMERIC)
+      pocsag_handlenumericword(word);
+    else if(msgmode==POCSAG_MODE_ALPHA)
+      pocsag_handledataword(word);
   }else if(!(word&0x80000000)){ //ADDRESS
+    //A new address ends the previous message.
+    pocsag_endmessage();
+    
     /* 18 bits of the address come from the address word's payload,
        but the lowest three bits come from the frame count, which is
        half of the word count.
      */
     pocsag_lastid=((word>>10)&0x1ffff8) | ((wordcount>>1)&7);
 
-    //Wipe the alphanumeric message state.
+    /* The two function bits follow the address.  By convention,
+       function 0 is a numeric page and 3 is alphanumeric.  Functions
+       1 and 2 are usually tone-only, but some networks send text on
+       them, so we treat them as alphanumeric.
+     */
+    msgfunction=(word>>11)&3;
+    msgmode=msgfunction ? POCSAG_MODE_ALPHA : POCSAG_MODE_NUMERIC;
+
+    //Wipe the message state.
     bitcount=0;
     newchar=0;
     bytecount=0;
+    pocsag_buffer[0]=0;
   }
 
   /* Increment the word count, because we need it to decode the
@@ -105,23 +344,168 @@ void pocsag_handleword(uint32_t word){
 #ifdef STANDALONE
 
 #include<stdio.h>
+#include<stdlib.h>
 #include<assert.h>
+#include<time.h>
 
+//! Encodes 21 bits of data into a codeword, for testing.
+static uint32_t pocsag_encode(uint32_t data){
+  uint32_t word=(data&0x1FFFFF)<<11;
 
-//! Performs error correction on the word, as best we can.
-static uint32_t pocsag_correct(uint32_t word){
-  /* Ideally we'll do the error correction, but for now we just check
-     parity.
-   */
-  if(__builtin_parityl(word)==1){
-    //printf("0x%lx has bad parity.\n", word);
+  //Append the BCH check bits, then the parity.
+  word|=((uint32_t) pocsag_syndrome(word))<<1;
+  if(__builtin_parityl(word))
+    word|=1;
+  return word;
+}
+
+//! Encodes up to five numeric characters into a data word, for testing.
+static uint32_t pocsag_encodenumeric(const char *digits){
+  uint32_t bits=0;
+  char c;
+  int i, n;
 
-    //Return idle, rather than damaged frame.
-    return 0x7a89c197;
+  //Unused digits are padded with spaces.
+  for(i=0; i<5; i++){
+    c=*digits ? *digits++ : ' ';
+    for(n=0; pocsag_numerics[n]!=c; n++);
+    bits=(bits<<4) | n;
   }
+  return pocsag_encode(0x100000|bits);
+}
+
+//! Tests numeric and multi-batch messages against the store.
+static void pocsag_storetest(){
+  const struct pocsag_message *msg;
+  uint16_t count;
+  int i;
+
+  //Flush whatever main() left behind.
+  pocsag_endmessage();
+  count=pocsag_messagecount;
+
+  /* A numeric page to RIC 1234 in frame 2.  That's 154 in the top
+     eighteen bits, 2 in the bottom three, and function 0.
+   */
+  pocsag_settime(1000);
+  pocsag_newbatch();
+  for(i=0; i<4; i++)
+    pocsag_handleword(POCSAG_IDLE);
+  pocsag_handleword(pocsag_encode(154<<2 | 0));
+  assert(pocsag_lastid==1234);
+  assert(pocsag_inmessage());
+  pocsag_handleword(pocsag_encodenumeric("555-1"));
+  pocsag_handleword(pocsag_encodenumeric("234"));
+  pocsag_handleword(POCSAG_IDLE);
+  assert(!pocsag_inmessage());
+  assert(pocsag_messagecount==count+1);
+  msg=pocsag_getmessage(0);
+  assert(msg->id==1234);
+  assert(msg->time==1000);
+  assert(msg->mode==POCSAG_MODE_NUMERIC);
+  assert(!strcmp(msg->text,"555-1234  "));
+
+  /* The alpha message from main(), but moved to the last frame so
+     that it breaks at the end of a whole sixteen-word batch.  The
+     frame number makes the RIC 147095 rather than 147092.
+   */
+  pocsag_settime(2000);
+  pocsag_newbatch();
+  for(i=0; i<14; i++)
+    pocsag_handleword(POCSAG_IDLE);
+  pocsag_handleword(0x08fa5e2b);
+  pocsag_handleword(0xe9d25fc7);
+  pocsag_newbatch();
+  assert(pocsag_inmessage());
+  assert(pocsag_messagecount==count+1);
+  pocsag_handleword(0x9ae159b4);
+  pocsag_handleword(0xab812aeb);
+  pocsag_handleword(0x9f600572);
+  pocsag_handleword(POCSAG_IDLE);
+  assert(!pocsag_inmessage());
+  assert(pocsag_messagecount==count+2);
+  msg=pocsag_getmessage(0);
+  assert(msg->id==147095);
+  assert(msg->time==2000);
+  assert(msg->mode==POCSAG_MODE_ALPHA);
+  assert(!strcmp(msg->text,"KK4VCZ: Jo"));
+
+  //The older message is still around.
+  assert(pocsag_getmessage(1)->id==1234);
+  assert(pocsag_getmessage(1)->time==1000);
+  assert(!pocsag_getmessage(POCSAG_STORELEN));
+
+  //Long messages are truncated rather than wrapped.
+  pocsag_newbatch();
+  pocsag_handleword(0x08fa5e2b);
+  for(i=0; i<16; i++)
+    pocsag_handleword(0xe9d25fc7);
+  pocsag_endmessage();
+  assert(!strncmp(pocsag_getmessage(0)->text,"KK",2));
+  assert(strlen(pocsag_getmessage(0)->text)==MAXPAGELEN-1);
+  assert(pocsag_messagecount==count+3);
+
+  //Filtered messages are decoded, but not stored.
+  pocsag_filter=1234;
+  pocsag_newbatch();
+  pocsag_handleword(0x08fa5e2b);
+  pocsag_handleword(POCSAG_IDLE);
+  assert(pocsag_messagecount==count+3);
+  pocsag_filter=0;
   
-  //Looks good, so return it.
-  return word;
+  printf("Store test passed.\n");
+}
+
+//! Benchmarks the error correction on randomly damaged codewords.
+static void pocsag_benchmark(){
+  const int trials=200000;
+  int errors, i, t;
+  int corrected, rejected, wrong;
+  uint32_t good, bad, fixed, mask;
+  clock_t start;
+  double seconds;
+
+  srand(0x1337);
+  for(errors=0; errors<=3; errors++){
+    corrected=rejected=wrong=0;
+    start=clock();
+    for(t=0; t<trials; t++){
+      good=pocsag_encode(rand());
+
+      //Flip the requested number of distinct bits.
+      mask=0;
+      for(i=0; i<errors; i++){
+        uint32_t bit;
+        do{
+          bit=1UL<<(rand()&31);
+        }while(mask&bit);
+        mask|=bit;
+      }
+      bad=good^mask;
+      
+      fixed=pocsag_correct(bad);
+      if(fixed==good)
+        corrected++;
+      else if(fixed==POCSAG_IDLE)
+        rejected++;
+      else
+        wrong++;
+    }
+    seconds=(double) (clock()-start)/CLOCKS_PER_SEC;
+
+    printf("%d bit errors: %6.2f%% corrected, %6.2f%% rejected, %d wrong, %.0f words/s\n",
+           errors,
+           corrected*100.0/trials,
+           rejected*100.0/trials,
+           wrong,
+           seconds>0 ? trials/seconds : 0.0);
+
+    //Up to two errors must be fixed, and three must never be miscorrected.
+    if(errors<=2)
+      assert(corrected==trials);
+    else
+      assert(wrong==0);
+  }
 }
 
 //! Unix command-line tool for testing.
@@ -165,6 +549,15 @@ int main(){
   
   //Damaged frame.
   pocsag_handleword(0x7a89f000);
+
+  //Single and double errors in the address are corrected.
+  assert(pocsag_correct(0x08fa5e2b^0x00000400)==0x08fa5e2b);
+  assert(pocsag_correct(0x08fa5e2b^0x80000002)==0x08fa5e2b);
+  //Parity errors are fixed too.
+  assert(pocsag_correct(0x08fa5e2b^0x00000001)==0x08fa5e2b);
+
+  pocsag_storetest();
+  pocsag_benchmark();
   
   return 0; //Doesn't work yet.
 }
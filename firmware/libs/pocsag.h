@@ -5,11 +5,40 @@
 
 #define MAXPAGELEN 32
 
+//! The IDLE codeword, also returned for damaged words.
+#define POCSAG_IDLE 0x7a89c197
+
+//! Number of completed messages kept in RAM.
+#define POCSAG_STORELEN 4
+
+//! No message is being assembled.
+#define POCSAG_MODE_NONE 0
+//! Numeric (BCD) message, function 0.
+#define POCSAG_MODE_NUMERIC 1
+//! Alphanumeric (7-bit) message.
+#define POCSAG_MODE_ALPHA 2
+
+//! A completed message.
+struct pocsag_message {
+  uint32_t id;            //RIC of the recipient.
+  uint32_t time;          //Timestamp from pocsag_settime().
+  uint8_t function;       //Function bits of the address word.
+  uint8_t mode;           //POCSAG_MODE_NUMERIC or POCSAG_MODE_ALPHA.
+  char text[MAXPAGELEN];  //Null-terminated, truncated if too long.
+};
+
 //! ID of the most recently received POCSAG message.
 extern uint32_t pocsag_lastid;
 //! String of the last page length.
 extern char pocsag_buffer[MAXPAGELEN];
+//! Count of messages completed since boot.
+extern uint16_t pocsag_messagecount;
+//! If non-zero, only messages to this RIC are stored.
+extern uint32_t pocsag_filter;
+
 
+//! Corrects up to two bit errors in a word, returning IDLE if it can't.
+uint32_t pocsag_correct(uint32_t word);
 
 //! Handle one codeword in POCSAG.
 void pocsag_handleword(uint32_t word);
@@ -17,4 +46,13 @@ void pocsag_handleword(uint32_t word);
 //! Call this once for every new POCSAG batch.
 void pocsag_newbatch();
 
+//! Sets the timestamp recorded on messages that complete from now on.
+void pocsag_settime(uint32_t time);
+//! Returns non-zero if a message is still being assembled.
+int pocsag_inmessage();
+//! Completes the message being assembled, if any, into the store.
+void pocsag_endmessage();
+//! Returns a stored message, zero being the newest, or NULL.
+const struct pocsag_message *pocsag_getmessage(int age);
+
 
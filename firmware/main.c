@@ -137,8 +137,7 @@ int main(void) {
   uart_init();
   
   // Setup and enable WDT 250ms, ACLK, interval timer
-  WDTCTL = WDT_ADLY_250;
-  SFRIE1 |= WDTIE;
+  app_frames(1);
 
 
   //'make sbwrftest' will flash an image that beacons repeatedly in
@@ -21,58 +21,61 @@ enum {
   LCDSTRING    = 0x03,
   DMESG        = 0x04,
   RANDINT      = 0x05,
+  SETBAUD      = 0x06,
+  READ         = 0x07,
+  WRITE        = 0x08,
 
   RADIOONOFF   = 0x10,
   RADIOCONFIG  = 0x11,
   RADIORX      = 0x12,
-  RADIOTX      = 0x13
+  RADIOTX      = 0x13,
+  RADIOSNIFF   = 0x14
 } monitor_verb;
 
 
+//! Longest READ reply, which comes from memory rather than our buffers.
+#define READMAX 256
+
 //! Local command to send the dmesg buffer.
 static void send_dmesg(){
-  uint16_t i;
-  char *dmesg_buffer=(char*)0x2400;
-  
-  //Start the frame.
-  uart_tx(0x00);
-  uart_tx(0x80);
-  //Length
-  uart_tx(DMESGLEN&0xFF);
-  uart_tx(DMESGLEN>>8);
-  
-  //dmesg
-  for(i=0;i<DMESGLEN;i++){
-    uart_tx(dmesg_buffer[i]);
-  }
-  //checksum
-  uart_tx(0x00);
-  uart_tx(0x00);
+  /* The buffer is sent in place by the TXIFG interrupt, so we return
+     long before the 2kB have gone out.
+   */
+  uart_txframe((uint8_t*) dmesg_buffer, DMESGLEN);
 }
 
-//! Local command to generate and send n random integers.
-static void send_randint(uint16_t n){
+//! Local command to send the dmesg characters that the host hasn't seen.
+static int send_dmesgsince(uint8_t *buffer){
+  /* The host sends a null, its last epoch and the sequence number of
+     the next character it wants.  We reply in the same layout with
+     the position of the characters that follow, which begin earlier
+     if the host fell behind or the buffer was cleared.  A reply with
+     no characters means the host has caught up.
+   */
+  uint16_t *buffer16=(uint16_t*) buffer;
+  uint32_t seq=buffer16[2] | ((uint32_t) buffer16[3])<<16;
+  uint16_t count;
+
+  count=dmesg_read(buffer16[1], &seq, (char*) buffer+8, UARTBUFLEN-8);
+  buffer16[1]=dmesg_epoch;
+  buffer16[2]=seq;
+  buffer16[3]=seq>>16;
+  return 8+count;
+}
 
+//! Local command to generate n random integers into the buffer.
+static int send_randint(uint8_t *buffer, uint16_t n){
   uint16_t i;
-  uint16_t len = n*2;
-  uint16_t rints[n]; // are var len arrays ok here?
+  uint16_t *rints=(uint16_t*) buffer;
 
-  for(i = 0; i < n; i++){ //pre-generate enough ints
+  //The reply must fit in the UART buffer.
+  if(n>UARTBUFLEN/2)
+    n=UARTBUFLEN/2;
+  
+  for(i = 0; i < n; i++){
     rints[i] = true_rand();
   }
-  //Start the frame
-  uart_tx(0x00);
-  uart_tx(0x80);
-  //Length
-  uart_tx(len&0xFF);
-  uart_tx(len>>8);
-  //Send integers byte by byte
-  for(i=0;i<len;i++){
-    uart_tx(((char*)rints)[i]);
-  }
-  // no checksum ?
-  uart_tx(0x00);
-  uart_tx(0x00);
+  return n*2;
 }
 
 //! Local pointer to packet.c's buffer.
@@ -80,11 +83,69 @@ static uint8_t *packetbuf=0;
 //! Local length.
 static int packetlen=0;
 
+//! Non-zero while every packet is pushed to the host as it arrives.
+static uint8_t sniffing=0;
+//! Count of packets received while sniffing, including dropped ones.
+static uint16_t sniffseq=0;
+
+//! Bytes of a sniffer record before the packet.
+#define SNIFFHEADER 10
+//! Longest packet that a sniffer record carries, the size of the RX FIFO.
+#define SNIFFMAX 64
+//! Sniffer record, which must outlive the call that fills it.
+static uint8_t sniffbuf[SNIFFHEADER+SNIFFMAX];
+
+//! Sends a packet to the host as an unsolicited sniffer record.
+static void sniffpacket(uint8_t *packet, int len){
+  /* The record is the verb, a null, a 16-bit sequence number, the raw
+     RSSI and LQI, the RTC time to 1/128 of a second, and then the
+     packet.  If the last record is still going out, this one is
+     dropped rather than stall the radio ISR, and the host sees a gap
+     in the sequence numbers.
+   */
+  sniffseq++;
+  if(uart_txbusy())
+    return;
+
+  /* With APPEND_STATUS, the radio follows each packet with the RSSI
+     and LQI of its reception.  The status registers have moved on to
+     the channel as it is now, so they're only read without it.
+   */
+  if((radio_readreg(PKTCTRL1)&0x04) && len>=2 && len<=PACKETLEN){
+    len-=2;
+    sniffbuf[4]=packet[len];
+    sniffbuf[5]=packet[len+1];
+  }else{
+    sniffbuf[4]=radio_readreg(RSSI);
+    sniffbuf[5]=radio_readreg(LQI);
+  }
+
+  if(len>SNIFFMAX)
+    len=SNIFFMAX;
+  sniffbuf[0]=RADIOSNIFF;
+  sniffbuf[1]=0;
+  sniffbuf[2]=sniffseq&0xFF;
+  sniffbuf[3]=sniffseq>>8;
+  sniffbuf[6]=RTCHOUR;
+  sniffbuf[7]=RTCMIN;
+  sniffbuf[8]=RTCSEC;
+  sniffbuf[9]=RTCPS1;
+  memcpy(sniffbuf+SNIFFHEADER, packet, len);
+  uart_txframe(sniffbuf, SNIFFHEADER+len);
+}
+
 //! Handles packet arrival, like an application would.
 void monitor_packetrx(uint8_t *packet, int len){
   /* This function is called by app_packetrx() in apps.c when a packet
      arrives and the uart is active.
    */
+  if(sniffing){
+    sniffpacket(packet, len);
+    //Right back to listening, so that nothing is missed.
+    packet_rxon();
+    return;
+  }
+  
   if(len<UARTBUFLEN-1){
     packetbuf=packet;
     packetlen=len;
@@ -141,18 +202,44 @@ int monitor_handle(uint8_t *buffer, int len){
       lcd_string("monitor ");
     }else{
       uartactive=0;
+      //Back to the 32kHz clock once our reply is out.
+      uart_setbaud(96);
     }
     break;
     
   case PEEK: //Null, then 16-bit parameter for address.
     if(buffer[1]==0){
-      buffer16[1] = *((uint16_t*)buffer16[1]);
+      buffer16[1] = *((uint16_t*) MEMPTR(buffer16[1]));
     }
     break;
     
   case POKE:
     if(buffer[1]==0){ //Null, the address, then value.
-      *((uint16_t*)buffer16[1]) = *((uint16_t*)buffer16[2]);
+      *((uint16_t*) MEMPTR(buffer16[1])) = buffer16[2];
+    }
+    break;
+
+  case READ: //Null, then 16-bit address and 16-bit length.
+    /* The reply is streamed straight out of memory, without the
+       command's header, so it needn't fit in our own buffers, but it
+       is kept short so that the host can retry cheaply when a frame
+       is damaged.  An empty READ is refused like an oversized one,
+       because there would be no frame to send back.
+     */
+    if(buffer[1]==0 && len>=6 && buffer16[2] && buffer16[2]<=READMAX){
+      uart_txframe(MEMPTR(buffer16[1]), buffer16[2]);
+      len=0;
+    }else{
+      len=1;
+    }
+    break;
+
+  case WRITE: //Null, then 16-bit address, then the bytes to write.
+    if(buffer[1]==0 && len>=4){
+      memcpy(MEMPTR(buffer16[1]), buffer+4, len-4);
+      len=4;  //The header alone is our acknowledgement.
+    }else{
+      len=1;
     }
     break;
 
@@ -162,13 +249,26 @@ int monitor_handle(uint8_t *buffer, int len){
     break;
     
   case DMESG:
-    send_dmesg();
-    len=0;
+    if(len>=8 && buffer[1]==0){
+      len=send_dmesgsince(buffer);
+    }else{
+      //Without a position, the whole buffer goes out as it lies.
+      send_dmesg();
+      len=0;
+    }
     break;
 
   case RANDINT:
-    send_randint((uint16_t)buffer16[1]);
-    len=0;
+    len=send_randint(buffer, buffer16[1]);
+    break;
+
+  case SETBAUD: //Null, then 16-bit rate in hundreds of baud.
+    /* The reply goes out at the old rate, with the null replaced by
+       one if the new rate will be used after it.  Older firmware
+       echoes the null, so the host knows to stay put.
+     */
+    if(buffer[1]==0 && uartactive)
+      buffer[1]=uart_setbaud(buffer16[1]);
     break;
 
   case RADIOONOFF: //One byte parameter, on or off.
@@ -186,6 +286,14 @@ int monitor_handle(uint8_t *buffer, int len){
   case RADIORX:
     return handlerx(buffer,len);
     break;
+  case RADIOSNIFF: //One byte parameter, on or off.
+    sniffing=buffer[1];
+    sniffseq=0;
+    if(sniffing)
+      packet_rxon();
+    else
+      packet_rxoff();
+    break;
   case RADIOTX:
     if(radio_getstate()==22){
       printf("TX Overflow.\n");
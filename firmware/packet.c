@@ -4,46 +4,99 @@
   This library is a companion to radio.c, allowing for reception and
   transmission of packets.
   
-  For now, we are limited to sixty byte packets that fit within the
-  radio's internal FIFO buffer.
+  Received packets may be longer than the radio's 64-byte FIFO, up to
+  PACKETLEN.  The FIFO is drained whenever it reaches its threshold
+  (RFIFG0), and what remains is read at the end of the packet
+  (RFIFG9).
+
+  Transmitted frames are copied into a small queue and streamed into
+  the TX FIFO from the interrupt handler, refilling whenever the FIFO
+  drains below its threshold (RFIFG2) or a frame ends (RFIFG9).  The
+  fills are DMA transfers, so the ISR returns while they complete.  The
+  radio is held in TX between frames (MCSM1.TXOFF_MODE), so repeated
+  OOK commands go out back-to-back without any gaps, rather than
+  waiting on the application to schedule each repetition.
   
 */
 
 #include<msp430.h>
 #include<stdio.h>
+#include<string.h>
 #include "api.h"
 
 //! Receive packet buffer, with room for RSSI and LQI.
 uint8_t rxbuffer[PACKETLEN+2];
 //! Length of received packet.
-uint8_t rxlen;
+uint16_t rxlen;
+//! Bytes of the packet being received that are already out of the FIFO.
+static uint16_t rxindex;
 
-//! Transmit packet buffer.
+//! Transmit packet buffer, holding the frames of the TX queue.
 uint8_t txbuffer[PACKETLEN];
 
 static int transmitting, receiving;
 
-//! Initialize the packet variables.  Only called from radio_on().
+//! Size of the radio's TX FIFO.
+#define FIFOLEN 64
+
+//! One frame of the TX queue, stored within txbuffer[].
+struct txframe {
+  uint8_t offset;  //Start of the frame within txbuffer[].
+  uint8_t length;  //Length of the frame.
+  uint8_t repeat;  //Remaining repetitions, or PACKET_REPEATFOREVER.
+};
+
+//! Frames waiting to be loaded into the FIFO.
+static struct txframe txqueue[TXQUEUELEN];
+//! Head of the TX queue and count of the frames in it.
+static uint8_t txhead, txcount;
+//! Bytes of txbuffer[] used by queued frames.
+static uint16_t txused;
+//! Bytes of the head frame that are already in the FIFO.
+static uint8_t txindex;
+//! Frames entirely within the FIFO, but not yet sent.
+static uint8_t txloaded;
+//! Non-zero while the radio is being held in TX between frames.
+static uint8_t txstreaming;
+//! MCSM1 value from before the burst, restored for its final frame.
+static uint8_t txmcsm1;
+
+//! Initialize the packet variables.  Only called from radio_on() and radio_off().
 void packet_init(){
+  //Quiet the interrupts before the radio is reset beneath us.
+  RF1AIE &= ~(BIT9|BIT2|BIT0);
+  RF1AIFG &= ~(BIT9|BIT2|BIT0);
+  
   transmitting=0;
   receiving=0;
+  rxindex=0;
+
+  txhead=0;
+  txcount=0;
+  txused=0;
+  txindex=0;
+  txloaded=0;
+  txstreaming=0;
 }
 
 //! Switch to receiving packets.
 void packet_rxon(){
+  DMESG_MARK(DMESG_MARK_RXON, 0);
   receiving=1;
+  rxindex=0;
   
   RF1AIES |= BIT9;    // Falling edge of RFIFG9
-  RF1AIFG &= ~BIT9;   // Clear a pending interrupt
-  RF1AIE  |= BIT9;    // Enable the interrupt
+  RF1AIES &= ~BIT0;   // Rising edge of RFIFG0, the RX FIFO threshold
+  RF1AIFG &= ~(BIT9|BIT0);   // Clear pending interrupts
+  RF1AIE  |= BIT9|BIT0;      // Enable the interrupts
   
   radio_strobe( RF_SRX );
 }
 
 //! Stop receiving packets.
 void packet_rxoff(){
-  RF1AIE &= ~BIT9;    // Disable RX interrupts
-  RF1AIFG &= ~BIT9;   // Clear pending IFG
+  RF1AIE &= ~(BIT9|BIT0);    // Disable RX interrupts
+  RF1AIFG &= ~(BIT9|BIT0);   // Clear pending IFG
 
   /* If RXOFF is called in the middle of a packet, it's necessary to
      flux the RX queue.
@@ -51,29 +104,146 @@ void packet_rxoff(){
   radio_strobe( RF_SIDLE );
   radio_strobe( RF_SFRX  );
   receiving=0;
+  DMESG_MARK(DMESG_MARK_RXOFF, 0);
 }
 
-//! Transmit a packet.
-void packet_tx(uint8_t *buffer, uint8_t length){
-  if(transmitting){
-    printf("Refusing to transmit with pending packet.\n");
-    return;
+/* The radio applies TXOFF_MODE at the end of every packet, so MCSM1
+   can only be restored once the final frame is the one on the air.
+   Restoring it any sooner would drop the radio to IDLE with frames
+   still sitting in the FIFO.
+ */
+static void packet_txlast(){
+  if(!txcount && txloaded<=1)
+    radio_writereg(MCSM1, txmcsm1);
+}
+
+//! Loads as much of the TX queue into the FIFO as will fit.
+static void packet_txfill(){
+  struct txframe *frame;
+  uint8_t room, count;
+
+  room=FIFOLEN-(radio_readreg(TXBYTES)&0x7F);
+  
+  while(txcount && room){
+    frame=&txqueue[txhead];
+    
+    //Frames may be split across refills, so long ones can be sent.
+    count=frame->length-txindex;
+    if(count>room)
+      count=room;
+    radio_writetxfifo(txbuffer+frame->offset+txindex, count);
+    room-=count;
+    txindex+=count;
+
+    if(txindex==frame->length){
+      //The whole frame is in the FIFO, so move on to the next.
+      txindex=0;
+      txloaded++;
+      if(frame->repeat!=PACKET_REPEATFOREVER && !--frame->repeat){
+        txhead=(txhead+1)%TXQUEUELEN;
+        txcount--;
+      }
+    }
   }
+
+  if(!txcount){
+    //Everything has been loaded, so we stop refilling.
+    RF1AIE &= ~BIT2;
+    txstreaming=0;
+  }
+  packet_txlast();
+}
+
+//! Begins a burst from the TX queue.
+static void packet_txstart(){
   transmitting=1;
+  txstreaming=1;
+  txindex=0;
+  txloaded=0;
   
-  RF1AIES |= BIT9;                          
-  RF1AIFG &= ~BIT9;                         // Clear pending interrupts
-  RF1AIE |= BIT9;                           // Enable TX end-of-packet interrupt
-
+  //Remain in TX between frames, so that repeats are gapless.
+  txmcsm1=radio_readreg(MCSM1);
+  radio_writereg(MCSM1, (txmcsm1&~0x03)|0x02);
+  
+  RF1AIES |= BIT9|BIT2;                     // Falling edges.
+  RF1AIFG &= ~(BIT9|BIT2);                  // Clear pending interrupts
+  RF1AIE |= BIT9|BIT2;                      // Enable end-of-packet and FIFO threshold.
   
-  //Write the packet into the buffer.
-  radio_writeburstreg(RF_TXFIFOWR, buffer, length);     
+  //Write the first frames into the FIFO.
+  packet_txfill();
 
   //Strobe into transmit mode.
   radio_strobe( RF_STX );
+}
+
+//! Queue a packet to be sent count times back-to-back.  Returns zero on failure.
+int packet_txrepeat(uint8_t *buffer, uint8_t length, uint8_t count){
+  struct txframe *frame;
   
+  if(!length || !count)
+    return 0;
+  if(txcount==TXQUEUELEN || txused+length>PACKETLEN){
+    printf("Refusing to transmit with a full queue.\n");
+    return 0;
+  }
+
+  //Copy the frame, so the caller needn't keep its buffer around.
+  frame=&txqueue[(txhead+txcount)%TXQUEUELEN];
+  frame->offset=txused;
+  frame->length=length;
+  frame->repeat=count;
+  memcpy(txbuffer+txused, buffer, length);
+  txused+=length;
+  txcount++;
+
+  /* A new burst begins if we are idle.  Otherwise the frame is picked
+     up by the next refill, or by the end of the current burst.
+   */
+  if(!transmitting)
+    packet_txstart();
+  
+  return 1;
 }
 
+//! Transmit a packet.
+void packet_tx(uint8_t *buffer, uint8_t length){
+  packet_txrepeat(buffer, length, 1);
+}
+
+//! Abort any transmission and flush the TX queue.
+void packet_txstop(){
+  if(!transmitting)
+    return;
+  
+  RF1AIE &= ~(BIT9|BIT2);
+  RF1AIFG &= ~(BIT9|BIT2);
+  
+  radio_strobe( RF_SIDLE );
+  radio_strobe( RF_SFTX );
+  radio_writereg(MCSM1, txmcsm1);
+
+  transmitting=0;
+  txhead=0;
+  txcount=0;
+  txused=0;
+  txstreaming=0;
+}
+
+/* Moves received bytes from the FIFO into rxbuffer[].  Until the
+   packet has ended, one byte is left behind, because reading the last
+   byte of the FIFO while more are arriving can return it twice.
+ */
+static void packet_rxdrain(int end){
+  uint16_t count=radio_readreg(RXBYTES)&0x7F;
+
+  if(!end && count)
+    count--;
+  //We read no more than our buffer.
+  if(count>PACKETLEN-rxindex)
+    count=PACKETLEN-rxindex;
+  radio_readrxfifo(rxbuffer+rxindex, count);
+  rxindex+=count;
+}
 
 //! Interrupt handler for incoming packets.
 void __attribute__ ((interrupt(CC1101_VECTOR)))
@@ -83,9 +253,17 @@ packet_isr (void) {
   
   switch(rf1aiv&~1){       // Prioritizing Radio Core Interrupt 
     case  0: break;                         // No RF core interrupt pending
-    case  2: break;                         // RFIFG0
+    case  2:                                // RFIFG0
+      //RX FIFO has filled to its threshold, so drain it.
+      if(receiving)
+        packet_rxdrain(0);
+      break;
     case  4: break;                         // RFIFG1
-    case  6: break;                         // RFIFG2
+    case  6:                                // RFIFG2
+      //TX FIFO has drained below its threshold, so top it off.
+      if(transmitting && txstreaming)
+        packet_txfill();
+      break;
     case  8: break;                         // RFIFG3
     case 10: break;                         // RFIFG4
     case 12: break;                         // RFIFG5
@@ -103,18 +281,17 @@ packet_isr (void) {
 
 
 	if(state==1){
-	  // Read the length byte from the FIFO.
-	  rxlen = radio_readreg( RXBYTES );
-	  //__delay_cycles(8500);
-	  
-	  /* We read no more than our buffer. */
-	  radio_readburstreg(RF_RXFIFORD, rxbuffer,
-			     rxlen>PACKETLEN?PACKETLEN:rxlen);
+	  /* The rest of the packet comes out by DMA rather than
+	     polling each byte through the instruction interface. */
+	  packet_rxdrain(1);
+	  rxlen=rxindex;
+	  rxindex=0;
 	  
 	  //Inform the application.
 	  app_packetrx(rxbuffer,rxlen);
 	}else if(state==17){
 	  printf("RX Overflow.  Idling.\n");
+	  rxindex=0;
 	  radio_strobe(RF_SIDLE);
 	}else{
 	  printf("Unknown RX state %d.\n",state);
@@ -132,10 +309,30 @@ packet_isr (void) {
 	*/
       }else if(transmitting){ //End of TX packet.
 	//printf("Transmitted packet.\n");
-        RF1AIE &= ~BIT9;     // Disable TX end-of-packet interrupt
-        transmitting = 0;
-	//Inform the application.
-	app_packettx();
+        if(txloaded)
+          txloaded--;
+        
+        if(txloaded){
+          //More frames are already in flight.
+          if(txcount && !txstreaming){
+            //Frames were queued after the last fill, so resume.
+            txstreaming=1;
+            RF1AIE |= BIT2;
+          }
+          if(txstreaming)
+            packet_txfill();
+          packet_txlast();
+        }else if(txcount){
+          //Frames were queued after the burst was loaded, so start anew.
+          packet_txstart();
+        }else{
+          RF1AIE &= ~(BIT9|BIT2); // Disable TX interrupts
+          transmitting = 0;
+          txhead = 0;
+          txused = 0;
+          //Inform the application.
+          app_packettx();
+        }
       }else{
 	printf("Unexpected packet ISR.\n");
       }
@@ -7,6 +7,11 @@
 //! Length of the packet buffer.
 #define PACKETLEN 256
 
+//! Number of distinct frames that may wait in the TX queue.
+#define TXQUEUELEN 4
+//! Repeat count that sends a frame until packet_txstop() or radio_off().
+#define PACKET_REPEATFOREVER 0xFF
+
 //! Receive packet buffer.
 extern uint8_t rxbuffer[];
 //! Transmit packet buffer.
@@ -23,3 +28,9 @@ void packet_rxoff();
 //! Transmit a packet.
 void packet_tx(uint8_t *buffer, uint8_t length);
 
+//! Queue a packet to be sent count times back-to-back.  Returns zero on failure.
+int packet_txrepeat(uint8_t *buffer, uint8_t length, uint8_t count);
+
+//! Abort any transmission and flush the TX queue.
+void packet_txstop();
+
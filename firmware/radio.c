@@ -21,6 +21,12 @@
   
   4) The CPU runs at 32kHz by default.  You can speed it up, but at
   the cost of power consumption.
+
+  5) Packet data moves through the FIFOs by DMA, using the direct
+  FIFO registers (RF1ATXFIFO, RF1ARXFIFO) and their RFTXIFG/RFRXIFG
+  triggers on channel 0.  A TX fill returns before the transfer is
+  complete, so every use of the instruction interface first calls
+  radio_dmawait().
   
 */
 
@@ -31,7 +37,12 @@
 #include "power.h"
 #include "radio.h"
 #include "configdefault.h"
+#include "dmesg.h"
+#include "ucs.h"
+
 
+//! Set while the radio holds a request for a fast MCLK.
+static int radio_racing=0;
 
 //! Cleared to zero at the first radio failure.
 int has_radio=1;
@@ -84,7 +95,7 @@ uint32_t radio_getfreq(){
 }
 
 
-// Only called from here.
+// Only called from radio_on() and radio_off().
 extern void packet_init();
 
 //! Called at boot.  Gracefully fails if no radio.
@@ -112,6 +123,8 @@ void radio_on(){
     return;
   }
 
+  DMESG_MARK(DMESG_MARK_RADIOON, 0);
+
   //Be sure to reset the radio variables, in case the state machine is
   //out of whack.  This should only be called from here, nowhere else.
   packet_init();
@@ -131,6 +144,12 @@ void radio_on(){
 
   //Strobe the radio to reset it.
   radio_resetcore();
+
+  //Packet interrupts race through the FIFOs at a fast MCLK.
+  if(!radio_racing){
+    radio_racing=1;
+    ucs_request(UCS_4MHZ);
+  }
 }
 
 //! Restarts the radio.
@@ -145,6 +164,14 @@ void radio_resetcore(){
 
 //! Turns the radio off.
 void radio_off(){
+  if(radio_racing){
+    radio_racing=0;
+    ucs_release(UCS_4MHZ);
+  }
+
+  //Abandon any queued packets, so no interrupt refills a dead FIFO.
+  packet_init();
+  
   //Cut the radio's oscillator.
   radio_strobe(RF_SRES);
   radio_strobe(RF_SXOFF);
@@ -161,11 +188,68 @@ void radio_off(){
   PMMCTL0_H = 0xA5;
   PMMCTL0_L &= ~PMMHPMRE_L;
   PMMCTL0_H = 0x00;
+
+  DMESG_MARK(DMESG_MARK_RADIOOFF, 0);
+}
+
+
+//! Waits until any DMA transfer to or from the FIFOs has completed.
+void radio_dmawait(){
+  /* DMAEN clears itself when a single-transfer block completes, so
+     this returns at once unless a FIFO fill is still in flight.
+   */
+  while(DMA0CTL & DMAEN);
+}
+
+//! Fill the TX FIFO by DMA, returning before the transfer completes.
+void radio_writetxfifo(uint8_t *buffer, uint8_t count){
+  if(!count)
+    return;
+  radio_dmawait();
+
+  //Trigger on the TX FIFO having room.
+  DMACTL0 = (DMACTL0 & ~0x1F) | DMA0TSEL__RFTXIFG;
+  __data16_write_addr((unsigned short) &DMA0SA, (unsigned long) buffer);
+  __data16_write_addr((unsigned short) &DMA0DA, (unsigned long) &RF1ATXFIFO);
+  DMA0SZ = count;
+
+  /* Single transfers of bytes, incrementing the source.  Triggers
+     from the radio must be edge sensitive, and RFTXIFG is already
+     high when we begin, so we request the first transfer ourselves.
+     The flag drops as the FIFO takes each byte, and its return is
+     the edge for the next.
+   */
+  DMA0CTL = DMADT_0 | DMASRCINCR_3 | DMADSTINCR_0
+    | DMASBDB | DMAEN;
+  DMA0CTL |= DMAREQ;
 }
 
+//! Drain the RX FIFO by DMA.
+void radio_readrxfifo(uint8_t *buffer, uint8_t count){
+  if(!count)
+    return;
+  radio_dmawait();
+
+  //Trigger on the RX FIFO holding data.
+  DMACTL0 = (DMACTL0 & ~0x1F) | DMA0TSEL__RFRXIFG;
+  __data16_write_addr((unsigned short) &DMA0SA, (unsigned long) &RF1ARXFIFO);
+  __data16_write_addr((unsigned short) &DMA0DA, (unsigned long) buffer);
+  DMA0SZ = count;
+  DMA0CTL = DMADT_0 | DMASRCINCR_0 | DMADSTINCR_3
+    | DMASBDB | DMAEN;
+  //RFRXIFG is already high, so the first transfer is ours to request.
+  DMA0CTL |= DMAREQ;
+
+  /* Every byte we asked for is already waiting in the FIFO, so this
+     is brief, and the caller needs the data before we can return.
+   */
+  radio_dmawait();
+}
 
 //! Read a register from the radio.
 uint8_t radio_readreg(uint8_t addr){
+  radio_dmawait();
+  
   // Check for valid configuration register address, 0x3E refers to PATABLE 
   if ((addr <= 0x2E) || (addr == 0x3E))
     // Send address + Instruction + 1 dummy byte (auto-read)
@@ -185,6 +269,7 @@ void radio_readburstreg(uint8_t addr,
 			uint8_t *buffer, uint8_t count){
   unsigned int i;
 
+  radio_dmawait();
   if(count > 0){
     while (!(RF1AIFCTL1 & RFINSTRIFG));       // Wait for INSTRIFG
     RF1AINSTR1B = (addr | RF_REGRD);          // Send addr of first conf. reg. to be read 
@@ -203,6 +288,7 @@ void radio_writeburstreg(uint8_t addr,
 			 uint8_t *buffer, uint8_t count){
   unsigned char i;
   
+  radio_dmawait();
   if(count > 0){
     while (!(RF1AIFCTL1 & RFINSTRIFG));       // Wait for the Radio to be ready for next instruction
     RF1AINSTRW = ((addr | RF_REGWR)<<8 ) + buffer[0]; // Send address + Instruction
@@ -217,6 +303,8 @@ void radio_writeburstreg(uint8_t addr,
 
 //! Write to a register in the radio.
 void radio_writereg(uint8_t addr, uint8_t value){
+  radio_dmawait();
+  
   // Wait until the radio is ready.
   while (!(RF1AIFCTL1 & RFINSTRIFG));
   
@@ -327,6 +415,8 @@ uint8_t radio_strobe(uint8_t strobe){
     return 0xFF;
   */
   
+  radio_dmawait();
+  
   // Check for valid strobe command 
   if((strobe == 0xBD) || ((strobe >= RF_SRES) && (strobe <= RF_SNOP))){
     // Clear the Status read flag 
@@ -38,6 +38,13 @@ void radio_readburstreg(uint8_t addr,
 void radio_writeburstreg(uint8_t addr,
 			 uint8_t *buffer, uint8_t count);
 
+//! Waits until any DMA transfer to or from the FIFOs has completed.
+void radio_dmawait();
+//! Fill the TX FIFO by DMA, returning before the transfer completes.
+void radio_writetxfifo(uint8_t *buffer, uint8_t count);
+//! Drain the RX FIFO by DMA.
+void radio_readrxfifo(uint8_t *buffer, uint8_t count);
+
 //! Writes a set of values ot the power table.
 void radio_writepatable(uint8_t *table, uint8_t count);
 
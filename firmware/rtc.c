@@ -168,7 +168,10 @@ void __attribute__ ((interrupt(RTC_VECTOR))) RTC_ISR (void){
   switch(RTCIV&~1){
     case 0: break;                          // No interrupts
     case 2: break;                          // RTCRDYIFG
-    case 4: break;                          // RTCTEVIFG
+    case 4:                                 // RTCTEVIFG Minute
+      battery_minute();
+      app_minute();
+      break;
     case 6:                                 // RTCAIFG Alarm
       if (!alarm_ringing) {
         //Sound the alarm!
@@ -10,14 +10,22 @@
   
   The sidebuttons will be deactivated when the UART's first
   transaction occurs.
+
+  Applets that stop the WDT's frames, such as the dozing clock and
+  Shabbat mode, can't poll the buttons, so they arm the buttons'
+  falling edges with sidebutton_arm().  The edge brings the frames
+  back, and the button is then polled as usual.
 */
 
 #include <stdint.h>
 #include <msp430.h>
 
-#include "keypad.h"
-#include "uart.h"
-#include "config.h"
+#include "api.h"
+
+//! Armed pins that were taken from the UART, to be given back.
+static uint8_t uartpins=0;
+//! Buttons whose edges have woken us since sidebutton_woken().
+static uint8_t woken=0;
 
 
 //! Activate the side butons.
@@ -56,3 +64,40 @@ int sidebutton_set(){
 #endif
   return 0;
 }
+
+//! Wakes the frames on a press of the side buttons in mask.
+void sidebutton_arm(uint8_t mask){
+  /* Port interrupts only work on I/O pins, so the UART gives them up
+     until we wake.  A host's first byte then wakes us as a press
+     would, and is lost, but the client retries it.
+   */
+  uartpins|=P1SEL&mask;
+  P1SEL&=~mask;
+  //A press pulls the pin low, so we wake on the falling edge.
+  P1IES|=mask;
+  P1IFG&=~mask;
+  P1IE|=mask;
+}
+
+//! Disarms the side buttons' edges, giving their pins back to the UART.
+void sidebutton_disarm(){
+  P1IE&=~(BIT5|BIT6);
+  P1IFG&=~(BIT5|BIT6);
+  P1SEL|=uartpins;
+  uartpins=0;
+}
+
+//! Returns the buttons whose edges have woken us, and forgets them.
+int sidebutton_woken(){
+  int buttons=woken;
+  woken=0;
+  return buttons;
+}
+
+//! An armed side button has been pressed.
+void __attribute__ ((interrupt(PORT1_VECTOR))) PORT1_ISR(void){
+  woken|=P1IFG&P1IE;
+  sidebutton_disarm();
+  //The frames return, so Mode, Set and the reset hold work again.
+  app_frames(1);
+}
@@ -8,3 +8,10 @@ void sidebutton_init();
 int sidebutton_mode();
 //! Is the Program/Set button pressed?
 int sidebutton_set();
+
+//! Wakes the frames on a press of the side buttons in mask.
+void sidebutton_arm(uint8_t mask);
+//! Disarms the side buttons' edges, giving their pins back to the UART.
+void sidebutton_disarm();
+//! Returns the buttons whose edges have woken us, and forgets them.
+int sidebutton_woken();
@@ -3,3 +3,5 @@
 
 #include <stdint.h>
 #include "printf.h"
+//printf() becomes a token writer when built with DMESG_TOKENS.
+#include "dmesgtok.h"
@@ -15,6 +15,18 @@
   the first command must be sent as individual bytes to raise the CPU
   speed.
 
+  Replies are not sent from the receive handler.  Instead, the TXIFG
+  interrupt loads one byte at a time, either from the outgoing frame,
+  whose body is read in place rather than copied, or between frames
+  from a small ring of raw bytes.  The CPU sleeps between bytes, so
+  the keypad, radio and further UART bytes are serviced while a long
+  reply, like the 2kB dmesg buffer, drains at 9600 baud.
+
+  Once the monitor is active, the host may ask for a faster rate with
+  the SETBAUD verb.  Those rates are clocked from the DCO by way of
+  SMCLK, and the UART returns to the 32kHz ACLK when the monitor exits
+  or when a framing error shows that the host has gone back to 9600.
+
 */
 
 #include<stdint.h>
@@ -23,10 +35,50 @@
 
 #include "uart.h"
 #include "monitor.h"
+#include "ucs.h"
+#include "libs/crc16.h"
 
 //! Set to 1 if the UART is active.
 int uartactive=0;
 
+//! One supported baud rate of the UART.
+struct uart_rate {
+  uint16_t hundreds;  //Rate in hundreds of baud.
+  uint8_t ssel;       //Clock source.
+  uint8_t br;         //Prescaler.
+  uint8_t mctl;       //Modulation.
+};
+
+/* 9600 baud comes from the 32kHz ACLK, as it always has.  Faster rates
+   borrow SMCLK from the DCO, at UCS_SMCLKDCO Hz.  The divisors are
+   from the User's Guide, without oversampling.
+ */
+static const struct uart_rate uart_rates[]={
+  {96,   UCSSEL_1,   3, UCBRS_3+UCBRF_0},  //ACLK, our default.
+  {192,  UCSSEL_2,  54, UCBRS_5+UCBRF_0},
+  {384,  UCSSEL_2,  27, UCBRS_2+UCBRF_0},
+  {576,  UCSSEL_2,  18, UCBRS_2+UCBRF_0},
+  {1152, UCSSEL_2,   9, UCBRS_1+UCBRF_0},
+  {0,0,0,0}
+};
+
+//! Rate now in use, and any rate to switch to after the reply.
+static const struct uart_rate *uart_rate=uart_rates, *uart_nextrate=0;
+
+//! Reconfigures the USCI for a rate.  Any byte in flight is lost.
+static void uart_applyrate(const struct uart_rate *rate){
+  UCA0CTL1 |= UCSWRST;                 // **Put state machine in reset**
+  ucs_smclkdco(rate->ssel==UCSSEL_2);
+  UCA0CTL1 = (UCA0CTL1&~(UCSSEL0|UCSSEL1)) | rate->ssel;
+  UCA0BR0 = rate->br;
+  UCA0BR1 = 0;
+  UCA0MCTL = rate->mctl;
+  UCA0CTL1 |= UCRXEIE;                 // Characters with errors interrupt too.
+  UCA0CTL1 &= ~UCSWRST;                // **Initialize USCI state machine**
+  UCA0IE |= UCRXIE;                    // Reset cleared the interrupt enables.
+  uart_rate=rate;
+}
+
 //! Initializes the UART if the host is listening.
 void uart_init(){
   printf("Initializing UART ");
@@ -39,89 +91,175 @@ void uart_init(){
   //P1DIR |= BIT6;         // Set P1.6 as TX output, but we use the pulling resistors instead of the output mode.
   P1SEL |= BIT5 + BIT6;  // Select P1.5 & P1.6 to UART function
 
-  UCA0CTL1 |= UCSWRST;                 // **Put state machine in reset**
-  UCA0CTL1 |= UCSSEL_1;                // ACLK
-  UCA0BR0 = 3;                         // 32kHz 9600 (see User's Guide)
-  UCA0BR1 = 0;                         // 32kHz 9600
-  UCA0MCTL = UCBRS_3 + UCBRF_0;        // Modln UCBRSx=0, UCBRFx=0,
+  //32kHz 9600 baud (see User's Guide) and the RX interrupt.
+  uart_applyrate(uart_rates);
+}
 
-  UCA0CTL1 &= ~UCSWRST;                // **Initialize USCI state machine**
-  UCA0IE |= UCRXIE;                    // Enable USCI_A0 RX interrupt
-  //UCA0IE |= UCTXIE;                    // Enable USCI_A0 TX interrupt
+//! Switches baud rate once the pending reply is out.  Returns 0 if unsupported.
+int uart_setbaud(uint16_t hundreds){
+  const struct uart_rate *rate;
 
+  for(rate=uart_rates; rate->hundreds; rate++){
+    if(rate->hundreds==hundreds){
+      uart_nextrate=rate;
+      return 1;
+    }
+  }
+  printf("Unsupported baud rate %u00.\n", hundreds);
+  return 0;
 }
 
+//! Size of the transmit ring, which must be a power of two.
+#define TXRINGLEN 32
+
+//! Transmit ring, drained one byte per TXIFG interrupt.
+static uint8_t txring[TXRINGLEN];
+//! Ring indices.  The head is moved by uart_tx(), the tail by the ISR.
+static volatile uint8_t txhead, txtail;
+
+static int uart_txnext();
+
 //! Transmit a byte to the UART.
 void uart_tx(uint8_t byte){
-  /* Wait for the buffer to free up, then send the byte.  It'd be
-     better to populate a ring buffer and dump then on TXIFG as
-     appropriate.
+  /* The byte goes into the ring and the TXIFG interrupt sends it
+     along.  Nearly all of our code runs inside interrupt handlers,
+     where the TX interrupt can't preempt us, so when the ring is full
+     we drain it by polling rather than wait forever.
    */
-  while (!(UCA0IFG&UCTXIFG));
-  UCA0TXBUF = byte;
+  while(((txhead+1)&(TXRINGLEN-1))==txtail){
+    while(!(UCA0IFG&UCTXIFG));
+    uart_txnext();
+  }
+  txring[txhead]=byte;
+  txhead=(txhead+1)&(TXRINGLEN-1);
+  UCA0IE |= UCTXIE;
 }
 
-//! UART receive buffer.
-uint8_t uart_buffer[UARTBUFLEN];
+/* Commands are received into one buffer while the reply to the last
+   command may still be going out of the other, so the host can keep
+   two commands in flight and not wait out a round trip for each.
+ */
+static uint8_t uart_buffers[2][UARTBUFLEN];
+//! Index of the buffer that the next command will be received into.
+static uint8_t rxsel;
 
 
+//! Body, length, position and running checksum of the outgoing frame.
+static const uint8_t *outbody;
+static volatile uint16_t outlength;
+static uint16_t outindex, outcrc;
+//! Frame that waits for the current one to finish.
+static const uint8_t *nextbody;
+static volatile uint16_t nextlength;
 
-static uint16_t outlength, outindex, outcrc;
+//! State of the outgoing frame.
+static enum {IDLE,HEAD,LL,LH,MSG,CRCL,CRCH} txstate=IDLE;
 
-//! Handle sending a UART byte.
-static void handle_txbyte(){
+//! Returns the next byte of the outgoing frame, or -1 when it's done.
+static int handle_txbyte(){
   /* For convenience, we use the same format and checksums as the BSL
      format.
 
-     "\x00"+ll+lh+msg+crc
+     "\x00\x80"+ll+lh+msg+crc
   */
-  
-  //State machine.
-  static enum {IDLE,LL,LH,MSG,CRCL,CRCH} state=IDLE;
 
-  //Do nothing whne the length is null.
+  //Do nothing when the length is null.
   if(outlength==0)
-    return;
+    return -1;
   
-  do{
-    switch(state){
-    case IDLE:
-      /* Send 0x00 0x80 as the first bytes of the message. */
-      uart_tx(0x00);
-      uart_tx(0x80);
-      state=LL;
-      break;
-    case LL:
-      uart_tx(outlength&0xFF);
-      state=LH;
-      break;
-    case LH:
-      uart_tx((outlength>>8));
-      outindex=0;
-      state=MSG;
-      break;
-    case MSG:
-      uart_tx(uart_buffer[outindex++]);
-      if(outindex==outlength)
-	state=CRCL;
-      break;
-    case CRCL:
-      uart_tx(outcrc&0xFF);
-      state=CRCH;
-      break;
-    case CRCH:
-      uart_tx((outcrc>>8));
-      state=IDLE;
-      
-      break;
-    }
-  }while(state!=IDLE);
+  switch(txstate){
+  case IDLE:
+    /* Send 0x00 0x80 as the first bytes of the message. */
+    txstate=HEAD;
+    return 0x00;
+  case HEAD:
+    txstate=LL;
+    return 0x80;
+  case LL:
+    txstate=LH;
+    return outlength&0xFF;
+  case LH:
+    outindex=0;
+    outcrc=0xFFFF;
+    txstate=MSG;
+    return outlength>>8;
+  case MSG:
+    /* The checksum covers exactly the bytes that go out, so a buffer
+       that changes beneath us, like dmesg, is still consistent.
+     */
+    if(outindex+1==outlength)
+      txstate=CRCL;
+    outcrc=crc16_update(outcrc, outbody[outindex]);
+    return outbody[outindex++];
+  case CRCL:
+    txstate=CRCH;
+    return outcrc&0xFF;
+  case CRCH:
+  default:
+    txstate=IDLE;
+    //Frame is finished, so its buffer may be reused.
+    outbody=nextbody;
+    outlength=nextlength;
+    nextlength=0;
+    return outcrc>>8;
+  }
+}
+
+//! Loads the next outgoing byte into TXBUF.  Returns 0 when idle.
+static int uart_txnext(){
+  int byte;
+
+  //Raw bytes from uart_tx() go between frames, never within one.
+  if(txhead!=txtail && txstate==IDLE){
+    UCA0TXBUF = txring[txtail];
+    txtail=(txtail+1)&(TXRINGLEN-1);
+    return 1;
+  }
+  byte=handle_txbyte();
+  if(byte<0)
+    return 0;
+  UCA0TXBUF = byte;
+  return 1;
+}
+
+//! Sends a frame from the TXIFG interrupt, without copying its body.
+void uart_txframe(const uint8_t *body, uint16_t length){
+  if(!length)
+    return;
+
+  /* One frame may wait behind the one on the wire.  A third must wait
+     for room, but the host doesn't send that many commands at once.
+   */
+  while(nextlength){
+    while(!(UCA0IFG&UCTXIFG));
+    uart_txnext();
+  }
+
+  if(outlength){
+    nextbody=body;
+    nextlength=length;
+  }else{
+    outbody=body;
+    outlength=length;
+  }
+  UCA0IE |= UCTXIE;
+}
+
+//! Returns 1 while bytes remain to be sent.
+int uart_txbusy(){
+  return outlength || txhead!=txtail || (UCA0STAT&UCBUSY);
+}
+
+//! Returns 1 if a buffer is being sent or waiting to be sent.
+static int uart_txusing(const uint8_t *buffer){
+  return (outlength && outbody==buffer) || (nextlength && nextbody==buffer);
 }
 
 //! Handle a UART byte.
 static void handle_rxbyte(uint8_t byte){
   /* For convenience, we use the same format and checksums as the BSL
-     format.
+     format.  A bad length or checksum is answered with a single error
+     byte, as the BSL would, in place of the 0x00 that begins a reply.
 
      "\x80"+ll+lh+msg+crc
   */
@@ -130,6 +268,8 @@ static void handle_rxbyte(uint8_t byte){
   static enum {IDLE,LL,LH,MSG,CRCL,CRCH} state=IDLE;
   //Length and index.
   static uint16_t length, index, crc;
+  //Buffer of the command.
+  static uint8_t *buffer;
   
 
   switch(state){
@@ -145,30 +285,48 @@ static void handle_rxbyte(uint8_t byte){
   case LH:
     length|= ((uint16_t)byte)<<8;
     index=0;
+    crc=0xFFFF;
     if(length>UARTBUFLEN){
       printf("Buffer length error.\n");
+      uart_tx(UARTNAK_LENGTH);
+      state=IDLE;
+    }else if(!length){
+      state=IDLE;
+    }else if(uart_txusing(uart_buffers[rxsel])){
+      //Both buffers are still busy with replies.
+      printf("UART busy, dropping command.\n");
+      uart_tx(UARTNAK_BUSY);
       state=IDLE;
     }else{
+      buffer=uart_buffers[rxsel];
       state=MSG;
     }
     break;
   case MSG:
-    uart_buffer[index++]=byte;
+    buffer[index++]=byte;
+    crc=crc16_update(crc, byte);
     if(index==length)
       state=CRCL;
     break;
   case CRCL:
-    crc=byte;
+    crc^=byte;
     state=CRCH;
     break;
   case CRCH:
-    crc|= ((uint16_t)byte)<<8;
+    crc^= ((uint16_t)byte)<<8;
     state=IDLE;
+
+    //Corrupted commands are refused, so that a POKE can't go astray.
+    if(crc){
+      printf("UART CRC error.\n");
+      uart_tx(UARTNAK_CRC);
+      break;
+    }
     
-    outlength=monitor_handle(uart_buffer, length);
-    outindex=0;
-    outcrc=crc;
-    handle_txbyte();
+    //The reply is sent by TXIFG interrupts as we sleep.
+    uart_txframe(buffer, monitor_handle(buffer, length));
+    //The next command goes into the other buffer.
+    rxsel^=1;
     break;
   }
   
@@ -180,12 +338,37 @@ void __attribute__ ((interrupt(USCI_A0_VECTOR))) USCI_A0_ISR (void){
   switch(UCA0IV&~1){
   case 0:break;                             // Vector 0 - no interrupt
   case 2:                                   // Vector 2 - RXIFG
+    /* A framing error at a high rate means the host has lost track of
+       us, perhaps by restarting at 9600 baud, so we fall back to the
+       ACLK rate where it will look for us.  UCRXEIE lets us see the
+       bad character, and reading it clears the error.
+     */
+    if(UCA0STAT&UCFE){
+      UCA0RXBUF;
+      if(uart_rate!=uart_rates)
+        uart_applyrate(uart_rates);
+      break;
+    }
     handle_rxbyte(UCA0RXBUF);
     break;
-  case 4:
-    //printf("TXIFG was triggered.\n");
-    //handle_txbyte();
-    break;                             // Vector 4 - TXIFG
+  case 4:                                   // Vector 4 - TXIFG
+    //Send the next byte, or stop interrupting when there is none.
+    if(!uart_txnext()){
+      UCA0IE &= ~UCTXIE;
+      /* Reading UCA0IV cleared the flag, but the buffer is still
+         empty, so we set it again.  Otherwise the next frame would
+         enable an interrupt that never comes.
+       */
+      UCA0IFG |= UCTXIFG;
+
+      //Change rates only after the reply's last bit is out.
+      if(uart_nextrate){
+        while(UCA0STAT&UCBUSY);
+        uart_applyrate(uart_nextrate);
+        uart_nextrate=0;
+      }
+    }
+    break;
   default: break;
   }
 }
@@ -5,17 +5,26 @@
 //! Set to 1 if the UART is active.
 extern int uartactive;
 
-//! UART buffer length.
-#define UARTBUFLEN 256
+//! UART buffer length.  There are two, so that the host may pipeline.
+#define UARTBUFLEN 128
 
-//! UART receive buffer.
-extern uint8_t uart_buffer[];
+//! Error replies, from the BSL's list.
+#define UARTNAK_CRC 0x52
+#define UARTNAK_LENGTH 0x54
+#define UARTNAK_BUSY 0x55
 
 
 //! Initializes the UART if the host is listening.
 void uart_init();
 
+//! Switches baud rate once the pending reply is out.  Returns 0 if unsupported.
+int uart_setbaud(uint16_t hundreds);
+
 //! Transmit a byte to the UART.
 void uart_tx(uint8_t byte);
 
+//! Sends a frame from the TXIFG interrupt, without copying its body.
+void uart_txframe(const uint8_t *body, uint16_t length);
 
+//! Returns 1 while bytes remain to be sent.
+int uart_txbusy();
@@ -2,30 +2,165 @@
   \brief Clocking functions.
   
   This module implements a minimal driver for the Unified Clock System
-  of the CC430F6137 and related devices.  In general, we try to run in
-  slow mode whenever possible, jumping to fast mode only during
-  diagnostics or if required (briefly) for a radio exchange.  At all
-  other times, we run the CPU at 32kHz for power efficiency.
-  
+  of the CC430F6137 and related devices.  ACLK always runs from the
+  XT1 crystal, and MCLK runs at one of the operating points below,
+  which is UCS_IDLESPEED unless some driver asks for more.
+
+  The FLL holds DCOCLKDIV at UCS_SMCLKDCO for SMCLK, so that the UART
+  and buzzer keep their rates, while DCOCLK runs four times faster.
+  MCLK divides DCOCLK down to one of the operating points of ucs.h,
+  which can change at any moment without waiting on the FLL.
+
+  Drivers that have heavy work, like the radio or the monitor at high
+  baud rates, request a faster point and release it when they are
+  done.  Requests are counted, and the governor runs MCLK at the
+  fastest point that anyone holds, or at UCS_IDLESPEED when nobody
+  holds one.  It is better to race through the work and get back to
+  LPM3 than to dawdle, because LPM3 stops MCLK and the DCO whatever
+  the operating point.
 */
 
 #include <msp430.h>
+#include <stdio.h>
 #include "api.h"
 
-//! Fast mode.
+//! ACLK ticks in a day, after which the RTC's time of day wraps.
+#define UCS_DAYTICKS (86400UL*32768UL)
+
+//! MCLK source and divider of each operating point.
+static const struct {
+  uint16_t selm, divm;
+} ucs_points[UCS_SPEEDS]={
+  {SELM_0, DIVM_0},  //XT1.
+  {SELM_3, DIVM_2},  //DCOCLK/4.
+  {SELM_3, DIVM_1},  //DCOCLK/2.
+  {SELM_3, DIVM_0},  //DCOCLK.
+};
+
+//! Outstanding requests for each operating point.
+static uint8_t requests[UCS_SPEEDS];
+//! Operating point in force.
+static enum ucs_speed speed=UCS_IDLESPEED;
+
+//! Seconds spent at each operating point.
+uint32_t ucs_seconds[UCS_SPEEDS];
+//! ACLK ticks at each operating point, short of a whole second.
+static uint16_t ticks[UCS_SPEEDS];
+//! Time of day in ACLK ticks when the operating point last changed.
+static uint32_t lastswitch;
+
+//! Time of day in ACLK ticks, from the RTC.
+static uint32_t ucs_now(){
+  uint16_t ps;
+  uint32_t sec;
+
+  /* In calendar mode, RTCPS0 and the low seven bits of RTCPS1 count
+     ACLK within the second.  If the second ticks while we read, the
+     prescalers wrap and we read again.
+   */
+  do{
+    ps=((RTCPS1&0x7F)<<8)|RTCPS0;
+    sec=(RTCHOUR*60L+RTCMIN)*60+RTCSEC;
+  }while((((RTCPS1&0x7F)<<8)|RTCPS0)<ps);
+  return sec*32768+ps;
+}
+
+//! Charges the time since the last switch to the operating point.
+static void ucs_account(){
+  uint32_t now=ucs_now();
+  uint32_t elapsed;
+
+  if(now>=lastswitch)
+    elapsed=now-lastswitch;
+  else
+    elapsed=now+UCS_DAYTICKS-lastswitch;
+  lastswitch=now;
+
+  elapsed+=ticks[speed];
+  ucs_seconds[speed]+=elapsed>>15;
+  ticks[speed]=elapsed&0x7FFF;
+}
+
+//! Sets MCLK to an operating point.
+static void ucs_apply(enum ucs_speed s){
+  UCSCTL4 = (UCSCTL4&~SELM_7) | ucs_points[s].selm;
+  UCSCTL5 = (UCSCTL5&~DIVM_7) | ucs_points[s].divm;
+}
+
+//! Moves to the fastest operating point that anyone wants.
+static void ucs_govern(){
+  int s;
+
+  for(s=UCS_SPEEDS-1; s>UCS_IDLESPEED && !requests[s]; s--);
+  if(s==speed)
+    return;
+
+  ucs_account();
+  speed=s;
+  ucs_apply(s);
+}
+
+//! Asks for MCLK at no slower than speed, until released.
+void ucs_request(enum ucs_speed s){
+  requests[s]++;
+  ucs_govern();
+}
+
+//! Releases an earlier request.
+void ucs_release(enum ucs_speed s){
+  if(requests[s])
+    requests[s]--;
+  ucs_govern();
+}
+
+//! Current operating point.
+enum ucs_speed ucs_speed(){
+  return speed;
+}
+
+//! Writes the time at each operating point to dmesg.
+void ucs_report(){
+  ucs_account();
+  printf("MCLK seconds: %ld at 32kHz, %ld at 1MHz, %ld at 2MHz, %ld at 4MHz.\n",
+         ucs_seconds[UCS_ACLK], ucs_seconds[UCS_1MHZ],
+         ucs_seconds[UCS_2MHZ], ucs_seconds[UCS_4MHZ]);
+}
+
+//! Fast mode, at the operating point of the governor.
 void ucs_fast(){
-  UCSCTL4 = SELM_3 + SELS_0 + SELA_0;  //XT1 for ACLK and SMCLK, MCLK from DCO.
+  ucs_apply(speed);
 }
 
 //! Slow mode.
 void ucs_slow(){
-  UCSCTL4 = SELM_0 + SELS_0 + SELA_0;    //XT1 for everything; very slow CPU.
+  ucs_apply(UCS_ACLK);    //XT1 for everything; very slow CPU.
 }
 
-//! Initialize the XT1 crystal, and stabilize it.
-void ucs_init(){
+//! Sources SMCLK from the DCO at UCS_SMCLKDCO Hz, or from XT1 at 32kHz.
+void ucs_smclkdco(int dco){
+  static int borrowed=0;
+
+  /* The UART can't run faster than 9600 baud from the crystal, so the
+     monitor borrows SMCLK.  Peripherals request the DCO only while
+     they are busy, so LPM3 idle current is unchanged.  The buzzer
+     also runs from SMCLK, and it will be badly out of tune until this
+     is switched back.
+   */
+  UCSCTL4 = (UCSCTL4&~(SELS0|SELS1|SELS2)) | (dco ? SELS_4 : SELS_0);
+
+  //The monitor keeps the CPU busy at those rates, so it races.
+  if(dco!=borrowed){
+    borrowed=dco;
+    if(dco)
+      ucs_request(UCS_4MHZ);
+    else
+      ucs_release(UCS_4MHZ);
+  }
+}
+
+//! Stabilizes the XT1 crystal, clearing its fault flags.
+void ucs_xt1(){
   uint16_t i=0;
-  
 
   // Loop until XT1 & DCO stabilizes
   do{
@@ -44,5 +179,27 @@ void ucs_init(){
   UCSCTL6 &= ~(XT1DRIVE_3);                 // Xtal is now stable, reduce drive
                                             // strength
   //See page 125 of the family guide.
+}
+
+//! Initialize the XT1 crystal, and stabilize it.
+void ucs_init(){
+  /* DCOCLK runs at four times DCOCLKDIV, 4.19MHz, which is within
+     DCORSEL_3 and well under the 8MHz limit of the lowest core
+     voltage.  The FLL is paused while we change it.
+   */
+  __bis_SR_register(SCG0);
+  UCSCTL0 = 0;                              // Lowest DCO tap to start.
+  UCSCTL1 = DCORSEL_3;
+  UCSCTL2 = FLLD_2 + 31;                    // (31+1) * 32768Hz * 4
+  __bic_SR_register(SCG0);
+
+  ucs_xt1();
+
+  /* XT1 drives ACLK and SMCLK, because the buzzer's tones assume a
+     32768Hz SMCLK.  ucs_smclkdco() borrows SMCLK for the UART, and
+     ucs_fast() chooses MCLK.
+   */
+  UCSCTL4 = SELM_3 + SELS_0 + SELA_0;
+  lastswitch=ucs_now();
   ucs_fast();
 }
@@ -8,7 +8,40 @@ void ucs_fast();
 //! Slow mode.
 void ucs_slow();
 
+//! SMCLK rate when sourced from DCOCLKDIV, with the FLL defaults.
+#define UCS_SMCLKDCO 1048576
+
+//! Sources SMCLK from the DCO at UCS_SMCLKDCO Hz, or from XT1 at 32kHz.
+void ucs_smclkdco(int dco);
+
 //! Initialize the XT1 crystal, and stabilize it.
 void ucs_init();
+//! Stabilizes the XT1 crystal, clearing its fault flags.
+void ucs_xt1();
+
+
+//! Operating points of MCLK, slowest first.
+enum ucs_speed {
+  UCS_ACLK,   //XT1 at 32kHz, as ucs_slow() gives.
+  UCS_1MHZ,   //DCOCLK/4, the same 1.05MHz as SMCLK.
+  UCS_2MHZ,   //DCOCLK/2, 2.10MHz, which ucs_fast() has always given.
+  UCS_4MHZ,   //DCOCLK, 4.19MHz, for racing through heavy work.
+  UCS_SPEEDS
+};
+
+//! Operating point when nothing has asked for more.
+#ifndef UCS_IDLESPEED
+#define UCS_IDLESPEED UCS_2MHZ
+#endif
 
+//! Asks for MCLK at no slower than speed, until released.
+void ucs_request(enum ucs_speed speed);
+//! Releases an earlier request.
+void ucs_release(enum ucs_speed speed);
+//! Current operating point.
+enum ucs_speed ucs_speed();
 
+//! Seconds spent at each operating point.
+extern uint32_t ucs_seconds[UCS_SPEEDS];
+//! Writes the time at each operating point to dmesg.
+void ucs_report();